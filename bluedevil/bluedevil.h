@@ -42,6 +42,27 @@
  *           set certain properties like whether the device is trusted, blocked, or provide an alias
  *           for it.
  *
+ *     - DeviceView
+ *         - The devices that match a predicate, like all the connected headsets. It keeps itself up
+ *           to date and tells through its signals which devices entered or left it.
+ *
+ *     - ManagerInfo, AdapterInfo and DeviceInfo
+ *         - Immutable views of the adapters and devices, published by the Manager whenever they
+ *           change, that can be read from any thread.
+ *
+ *     - PendingCall
+ *         - Returned by the operations that need an answer from BlueZ, like pairing or connecting a
+ *           device. It never blocks, and it informs through its finished signal whether the
+ *           operation succeeded.
+ *
+ *     - OperationScheduler
+ *         - Queues pair and connect requests on the devices of an adapter, and sends a limited
+ *           number of them to BlueZ at the same time, by priority.
+ *
+ *     - TraceReplayer
+ *         - Replays a trace of the signals from BlueZ recorded through the Manager, without a bus,
+ *           to reproduce and profile the behaviour of the library offline.
+ *
  *     - Utils
  *         - Contains general usage routines.
  *
@@ -138,8 +159,16 @@
 #define BLUEDEVIL_H
 
 #include <bluedevil/bluedevildevice.h>
+#include <bluedevil/bluedevildeviceview.h>
+#include <bluedevil/bluedevildiscoveryfilter.h>
+#include <bluedevil/bluedevilinfo.h>
 #include <bluedevil/bluedeviladapter.h>
 #include <bluedevil/bluedevilmanager.h>
+#include <bluedevil/bluedeviloperationscheduler.h>
+#include <bluedevil/bluedevilpendingcall.h>
+#include <bluedevil/bluedevilrssihistory.h>
+#include <bluedevil/bluedevilstatistics.h>
+#include <bluedevil/bluedeviltracereplayer.h>
 #include <bluedevil/bluedevilutils.h>
 
 #endif // BLUEDEVIL_H
@@ -22,9 +22,17 @@
 
 #include "bluedeviladapter.h"
 #include "bluedevildevice.h"
+#include "bluedevildiscoveryfilter.h"
+#include "bluedeviloperationscheduler.h"
+#include "bluedevilpendingcall.h"
+#include "bluedevilstatistics_p.h"
+#include "bluedevilutils_p.h"
 
 #include "bluedevil/bluezadapter1.h"
-#include "bluedevil/dbusproperties.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QTimer>
 
 namespace BlueDevil {
 
@@ -37,26 +45,78 @@ public:
     Private(Adapter *q);
     ~Private();
 
-    void startDiscovery();
+    PendingCall *startDiscovery();
+    typedef void (Private::*PropertyHandler)(const QVariant &value, bool notify);
+    typedef QHash<QString, PropertyHandler> PropertyHandlers;
+    static PropertyHandlers createPropertyHandlers();
+
+    void initProperties(const QVariantMap &properties);
+    void setCachedProperty(const QString &property, const QVariant &value, bool notify = false);
+
+    void setAddress(const QVariant &value, bool notify);
+    void setName(const QVariant &value, bool notify);
+    void setAlias(const QVariant &value, bool notify);
+    void setAdapterClass(const QVariant &value, bool notify);
+    void setPowered(const QVariant &value, bool notify);
+    void setDiscoverable(const QVariant &value, bool notify);
+    void setPairable(const QVariant &value, bool notify);
+    void setPairableTimeout(const QVariant &value, bool notify);
+    void setDiscoverableTimeout(const QVariant &value, bool notify);
+    void setDiscovering(const QVariant &value, bool notify);
+    void setUUIDs(const QVariant &value, bool notify);
+    void setModalias(const QVariant &value, bool notify);
 
     void _k_deviceRemoved(const QString &objectPath);
-    void _k_propertyChanged(const QString &property, const QVariantMap &changed_properties, const QStringList &invalidated_properties);
+    void _k_propertyChanged(const QVariantMap &changed_properties, const QStringList &invalidated_properties);
     void _k_devicePropertyChanged(const QString &property, const QVariant &value);
+    void _k_flushDeviceChanges();
 
     org::bluez::Adapter1               *m_bluezAdapterInterface;
-    org::freedesktop::DBus::Properties *m_dbusPropertiesInterface;
+    OperationScheduler                 *m_operationScheduler;
 
-    QMap<QString, Device*>    m_devicesMap;
-    QMap<QString, Device*>    m_devicesMapUBIKey;
-    QMap<QString, Device*>    m_unpairedDevices;
+    // By address key, which keeps them listed in address order without sorting
+    QMap<quint64, Device*>    m_devicesMap;
+    QHash<QString, Device*>   m_devicesMapUBIKey;
+    QMap<quint64, Device*>    m_unpairedDevices;
 
     bool           m_stableDiscovering;
 
+    // Coalesced device changes
+    int                 m_coalescingInterval;
+    QTimer              m_coalescingTimer;
+    QList<Device*>      m_changedDevices;       // in the order they first changed, 0 once removed
+    QHash<Device*, int> m_changedDeviceIndexes; // in m_changedDevices
+    quint32             m_changedMask;
+
+    // Bluez cached properties
+    QString        m_address;
+    QString        m_name;
+    QString        m_alias;
+    quint32        m_adapterClass;
+    bool           m_powered;
+    bool           m_discoverable;
+    bool           m_pairable;
+    quint32        m_pairableTimeout;
+    quint32        m_discoverableTimeout;
+    bool           m_discovering;
+    UUIDSet        m_UUIDs;
+    QString        m_modalias;
+
     Adapter *const m_q;
 };
 
 Adapter::Private::Private(Adapter *q)
-    : m_stableDiscovering(false)
+    : m_operationScheduler(0)
+    , m_stableDiscovering(false)
+    , m_coalescingInterval(-1)
+    , m_changedMask(0)
+    , m_adapterClass(0)
+    , m_powered(false)
+    , m_discoverable(false)
+    , m_pairable(false)
+    , m_pairableTimeout(0)
+    , m_discoverableTimeout(0)
+    , m_discovering(false)
     , m_q(q)
 {
 }
@@ -64,47 +124,165 @@ Adapter::Private::Private(Adapter *q)
 Adapter::Private::~Private()
 {
     delete m_bluezAdapterInterface;
-    delete m_dbusPropertiesInterface;
 }
 
-void Adapter::Private::startDiscovery()
+PendingCall *Adapter::Private::startDiscovery()
+{
+    return new PendingCall(m_bluezAdapterInterface->StartDiscovery(), "org.bluez.Adapter1", "StartDiscovery", m_q);
+}
+
+void Adapter::Private::initProperties(const QVariantMap &properties)
+{
+    QVariantMap::const_iterator i;
+    for (i = properties.constBegin(); i != properties.constEnd(); ++i) {
+        setCachedProperty(i.key(), i.value());
+    }
+}
+
+Adapter::Private::PropertyHandlers Adapter::Private::createPropertyHandlers()
+{
+    PropertyHandlers handlers;
+    handlers.insert("Address", &Private::setAddress);
+    handlers.insert("Name", &Private::setName);
+    handlers.insert("Alias", &Private::setAlias);
+    handlers.insert("Class", &Private::setAdapterClass);
+    handlers.insert("Powered", &Private::setPowered);
+    handlers.insert("Discoverable", &Private::setDiscoverable);
+    handlers.insert("Pairable", &Private::setPairable);
+    handlers.insert("PairableTimeout", &Private::setPairableTimeout);
+    handlers.insert("DiscoverableTimeout", &Private::setDiscoverableTimeout);
+    handlers.insert("Discovering", &Private::setDiscovering);
+    handlers.insert("UUIDs", &Private::setUUIDs);
+    handlers.insert("Modalias", &Private::setModalias);
+    return handlers;
+}
+
+void Adapter::Private::setCachedProperty(const QString &property, const QVariant &value, bool notify)
+{
+    // An invalid value means the property has been invalidated, and the handlers fall back to
+    // the defaults
+    static const PropertyHandlers handlers = createPropertyHandlers();
+
+    const PropertyHandler handler = handlers.value(property);
+    if (handler) {
+        (this->*handler)(value, notify);
+    }
+}
+
+void Adapter::Private::setAddress(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_address = value.toString();
+}
+
+void Adapter::Private::setName(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_name = value.toString();
+}
+
+void Adapter::Private::setAlias(const QVariant &value, bool notify)
 {
-    m_bluezAdapterInterface->StartDiscovery();
+    m_alias = value.toString();
+    // name() is the alias
+    if (notify) {
+        emit m_q->nameChanged(m_alias);
+    }
+}
+
+void Adapter::Private::setAdapterClass(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_adapterClass = value.toUInt();
+}
+
+void Adapter::Private::setPowered(const QVariant &value, bool notify)
+{
+    m_powered = value.toBool();
+    if (notify) {
+        emit m_q->poweredChanged(m_powered);
+    }
+}
+
+void Adapter::Private::setDiscoverable(const QVariant &value, bool notify)
+{
+    m_discoverable = value.toBool();
+    if (notify) {
+        emit m_q->discoverableChanged(m_discoverable);
+    }
+}
+
+void Adapter::Private::setPairable(const QVariant &value, bool notify)
+{
+    m_pairable = value.toBool();
+    if (notify) {
+        emit m_q->pairableChanged(m_pairable);
+    }
+}
+
+void Adapter::Private::setPairableTimeout(const QVariant &value, bool notify)
+{
+    m_pairableTimeout = value.toUInt();
+    if (notify) {
+        emit m_q->pairableTimeoutChanged(m_pairableTimeout);
+    }
+}
+
+void Adapter::Private::setDiscoverableTimeout(const QVariant &value, bool notify)
+{
+    m_discoverableTimeout = value.toUInt();
+    if (notify) {
+        emit m_q->discoverableTimeoutChanged(m_discoverableTimeout);
+    }
+}
+
+void Adapter::Private::setDiscovering(const QVariant &value, bool notify)
+{
+    m_discovering = value.toBool();
+    if (notify) {
+        emit m_q->discoveringChanged(m_discovering);
+    }
+}
+
+void Adapter::Private::setUUIDs(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_UUIDs.setUUIDs(value.toStringList());
+}
+
+void Adapter::Private::setModalias(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_modalias = value.toString();
 }
 
 void Adapter::Private::_k_deviceRemoved(const QString &objectPath)
 {
     Device *const device = m_devicesMapUBIKey.take(objectPath);
     if (device) {
-        m_devicesMap.remove(m_devicesMap.key(device));
-        m_unpairedDevices.remove(objectPath);
+        m_devicesMap.remove(device->addressKey());
+        m_unpairedDevices.remove(device->addressKey());
+        const QHash<Device*, int>::iterator changedIt = m_changedDeviceIndexes.find(device);
+        if (changedIt != m_changedDeviceIndexes.end()) {
+            m_changedDevices[changedIt.value()] = 0;
+            m_changedDeviceIndexes.erase(changedIt);
+        }
         emit m_q->deviceRemoved(device);
         delete device;
     }
 }
 
-void Adapter::Private::_k_propertyChanged(const QString &interface_name, const QVariantMap &changed_properties, const QStringList &invalidated_properties)
+void Adapter::Private::_k_propertyChanged(const QVariantMap &changed_properties, const QStringList &invalidated_properties)
 {
+    Q_FOREACH (const QString &property, invalidated_properties) {
+        setCachedProperty(property, QVariant(), true);
+        emit m_q->propertyChanged(property, QVariant());
+    }
+
     QVariantMap::const_iterator i;
     for(i = changed_properties.constBegin(); i != changed_properties.constEnd(); ++i) {
-      QVariant value = i.value();
-      QString property = i.key();
-      if (property == "Alias") {
-          emit m_q->nameChanged(value.toString());
-      } else if (property == "Powered") {
-          emit m_q->poweredChanged(value.toBool());
-      } else if (property == "Discoverable") {
-          emit m_q->discoverableChanged(value.toBool());
-      } else if (property == "Pairable") {
-          emit m_q->pairableChanged(value.toBool());
-      } else if (property == "PairableTimeout") {
-          emit m_q->pairableTimeoutChanged(value.toUInt());
-      } else if (property == "DiscoverableTimeout") {
-          emit m_q->discoverableTimeoutChanged(value.toUInt());
-      } else if (property == "Discovering") {
-          emit m_q->discoveringChanged(value.toBool());
-      }
-      emit m_q->propertyChanged(property, value);
+      setCachedProperty(i.key(), i.value(), true);
+      emit m_q->propertyChanged(i.key(), i.value());
     }
 }
 
@@ -116,32 +294,57 @@ void Adapter::Private::_k_devicePropertyChanged(const QString& property, const Q
     emit m_q->deviceChanged(device);
 }
 
+void Adapter::Private::_k_flushDeviceChanges()
+{
+    m_coalescingTimer.stop();
+    if (m_changedDeviceIndexes.isEmpty()) {
+        m_changedDevices.clear();
+        m_changedMask = 0;
+        return;
+    }
+
+    QList<Device*> devices;
+    devices.reserve(m_changedDeviceIndexes.count());
+    Q_FOREACH (Device *const device, m_changedDevices) {
+        if (device) {
+            devices << device;
+        }
+    }
+    const quint32 changedMask = m_changedMask;
+    m_changedDevices.clear();
+    m_changedDeviceIndexes.clear();
+    m_changedMask = 0;
+
+    emit m_q->devicesChanged(devices, changedMask);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Adapter::Adapter(const QString &adapterPath, QObject *parent)
+Adapter::Adapter(const QString &adapterPath, const QVariantMap &properties, QObject *parent)
     : QObject(parent)
     , d(new Private(this))
 {
+    d->initProperties(properties);
+    d->m_coalescingTimer.setSingleShot(true);
+    connect(&d->m_coalescingTimer, SIGNAL(timeout()), this, SLOT(_k_flushDeviceChanges()));
     d->m_bluezAdapterInterface = new org::bluez::Adapter1("org.bluez", adapterPath, QDBusConnection::systemBus(), this);
-    d->m_dbusPropertiesInterface = new org::freedesktop::DBus::Properties("org.bluez", adapterPath, QDBusConnection::systemBus(), this);
-
-    connect(d->m_dbusPropertiesInterface, SIGNAL(PropertiesChanged(QString,QVariantMap,QStringList)),
-            this, SLOT(_k_propertyChanged(QString,QVariantMap,QStringList)));
 }
 
 Adapter::~Adapter()
 {
+    // Before the devices, so that its requests are canceled rather than orphaned one by one
+    delete d->m_operationScheduler;
     delete d;
 }
 
 QString Adapter::address() const
 {
-    return d->m_bluezAdapterInterface->address();
+    return d->m_address;
 }
 
 QString Adapter::name() const
 {
-    return d->m_bluezAdapterInterface->alias();
+    return d->m_alias;
 }
 
 QString Adapter::alias() const
@@ -151,42 +354,42 @@ QString Adapter::alias() const
 
 QString Adapter::systemName() const
 {
-    return d->m_bluezAdapterInterface->name();
+    return d->m_name;
 }
 
 quint32 Adapter::adapterClass() const
 {
-    return d->m_bluezAdapterInterface->adapterClass();
+    return d->m_adapterClass;
 }
 
 bool Adapter::isPowered() const
 {
-    return d->m_bluezAdapterInterface->powered();
+    return d->m_powered;
 }
 
 bool Adapter::isDiscoverable() const
 {
-    return d->m_bluezAdapterInterface->discoverable();
+    return d->m_discoverable;
 }
 
 bool Adapter::isPairable() const
 {
-    return d->m_bluezAdapterInterface->pairable();
+    return d->m_pairable;
 }
 
 quint32 Adapter::paireableTimeout() const
 {
-    return d->m_bluezAdapterInterface->pairableTimeout();
+    return d->m_pairableTimeout;
 }
 
 quint32 Adapter::discoverableTimeout() const
 {
-    return d->m_bluezAdapterInterface->discoverableTimeout();
+    return d->m_discoverableTimeout;
 }
 
 bool Adapter::isDiscovering() const
 {
-    return d->m_bluezAdapterInterface->discovering();
+    return d->m_discovering;
 }
 
 QList<Device*> Adapter::unpairedDevices() const
@@ -196,32 +399,52 @@ QList<Device*> Adapter::unpairedDevices() const
 
 Device *Adapter::deviceForAddress(const QString &address)
 {
-    if (d->m_devicesMap.contains(address)) {
-        return d->m_devicesMap[address];
-    }
-    return 0;
+    return d->m_devicesMap.value(addressToKey(address));
 }
 
 Device *Adapter::deviceForUBI(const QString &UBI)
 {
-    if (d->m_devicesMapUBIKey.contains(UBI)) {
-        return d->m_devicesMapUBIKey[UBI];
-    }
-    return 0;
+    return d->m_devicesMapUBIKey.value(UBI);
 }
 
 QStringList Adapter::UUIDs()
 {
-    QStringList UUIDs = d->m_bluezAdapterInterface->uUIDs();
-    for(int i=0;i<UUIDs.size();i++) {
-      UUIDs[i] = UUIDs.value(i).toUpper();
+    return d->m_UUIDs.UUIDs();
+}
+
+bool Adapter::hasProfile(const QString &UUID) const
+{
+    return d->m_UUIDs.contains(UUID);
+}
+
+quint32 Adapter::profiles() const
+{
+    return d->m_UUIDs.profiles();
+}
+
+QString Adapter::modalias() const
+{
+    return d->m_modalias;
+}
+
+int Adapter::changeCoalescingInterval() const
+{
+    return d->m_coalescingInterval;
+}
+
+void Adapter::setChangeCoalescingInterval(int msec)
+{
+    d->m_coalescingInterval = msec < 0 ? -1 : msec;
+    if (d->m_coalescingInterval == -1) {
+        d->_k_flushDeviceChanges();
     }
-    return UUIDs;
 }
 
 void Adapter::setName(const QString& name)
 {
+    SynchronousCall call("org.bluez.Adapter1", "Alias", CallStatistics::SetCall);
     d->m_bluezAdapterInterface->setAlias(name);
+    call.setFailed(d->m_bluezAdapterInterface->lastError().isValid());
 }
 
 void Adapter::setAlias(const QString &alias)
@@ -231,50 +454,78 @@ void Adapter::setAlias(const QString &alias)
 
 void Adapter::setPowered(bool powered)
 {
+    SynchronousCall call("org.bluez.Adapter1", "Powered", CallStatistics::SetCall);
     d->m_bluezAdapterInterface->setPowered(powered);
+    call.setFailed(d->m_bluezAdapterInterface->lastError().isValid());
 }
 
 void Adapter::setDiscoverable(bool discoverable)
 {
+    SynchronousCall call("org.bluez.Adapter1", "Discoverable", CallStatistics::SetCall);
     d->m_bluezAdapterInterface->setDiscoverable(discoverable);
+    call.setFailed(d->m_bluezAdapterInterface->lastError().isValid());
 }
 
 void Adapter::setPairable(bool pairable)
 {
+    SynchronousCall call("org.bluez.Adapter1", "Pairable", CallStatistics::SetCall);
     d->m_bluezAdapterInterface->setPairable(pairable);
+    call.setFailed(d->m_bluezAdapterInterface->lastError().isValid());
 }
 
 void Adapter::setPaireableTimeout(quint32 paireableTimeout)
 {
+    SynchronousCall call("org.bluez.Adapter1", "PairableTimeout", CallStatistics::SetCall);
     d->m_bluezAdapterInterface->setPairableTimeout(paireableTimeout);
+    call.setFailed(d->m_bluezAdapterInterface->lastError().isValid());
 }
 
 void Adapter::setDiscoverableTimeout(quint32 discoverableTimeout)
 {
+    SynchronousCall call("org.bluez.Adapter1", "DiscoverableTimeout", CallStatistics::SetCall);
     d->m_bluezAdapterInterface->setDiscoverableTimeout(discoverableTimeout);
+    call.setFailed(d->m_bluezAdapterInterface->lastError().isValid());
 }
 
-void Adapter::removeDevice(Device *device)
+PendingCall *Adapter::removeDevice(Device *device)
 {
-    d->m_bluezAdapterInterface->RemoveDevice(QDBusObjectPath(device->UBI()));
+    return new PendingCall(d->m_bluezAdapterInterface->RemoveDevice(QDBusObjectPath(device->UBI())), "org.bluez.Adapter1", "RemoveDevice", this);
 }
 
-void Adapter::startDiscovery() const
+PendingCall *Adapter::startDiscovery() const
 {
     d->m_stableDiscovering = false;
-    d->startDiscovery();
+    return d->startDiscovery();
 }
 
-void Adapter::startStableDiscovery() const
+PendingCall *Adapter::startStableDiscovery() const
 {
     d->m_stableDiscovering = true;
-    d->startDiscovery();
+    return d->startDiscovery();
+}
+
+PendingCall *Adapter::setDiscoveryFilter(const DiscoveryFilter &filter)
+{
+    return new PendingCall(d->m_bluezAdapterInterface->SetDiscoveryFilter(filter.toVariantMap()), "org.bluez.Adapter1", "SetDiscoveryFilter", this);
+}
+
+PendingCall *Adapter::clearDiscoveryFilter()
+{
+    return new PendingCall(d->m_bluezAdapterInterface->SetDiscoveryFilter(QVariantMap()), "org.bluez.Adapter1", "SetDiscoveryFilter", this);
+}
+
+OperationScheduler *Adapter::operationScheduler()
+{
+    if (!d->m_operationScheduler) {
+        d->m_operationScheduler = new OperationScheduler(this);
+    }
+    return d->m_operationScheduler;
 }
 
-void Adapter::stopDiscovery() const
+PendingCall *Adapter::stopDiscovery() const
 {
     d->m_stableDiscovering = false;
-    d->m_bluezAdapterInterface->StopDiscovery();
+    return new PendingCall(d->m_bluezAdapterInterface->StopDiscovery(), "org.bluez.Adapter1", "StopDiscovery", const_cast<Adapter*>(this));
 }
 
 QList< Device* > Adapter::devices()
@@ -282,18 +533,26 @@ QList< Device* > Adapter::devices()
     return d->m_devicesMap.values();
 }
 
-void Adapter::addDevice(const QString &objectPath)
+Device *Adapter::addDevice(const QString &objectPath, const QVariantMap &properties)
 {
-    Device * device = new Device(objectPath,this);
-    d->m_devicesMap.insert(device->address(),device);
+    Device * device = new Device(objectPath, properties, this);
+    d->m_devicesMap.insert(device->addressKey(), device);
     d->m_devicesMapUBIKey.insert(objectPath,device);
-    emit deviceFound(device);
     if(!device->isPaired()) {
-        d->m_unpairedDevices.insert(objectPath,device);
-        emit unpairedDeviceFound(device);
+        d->m_unpairedDevices.insert(device->addressKey(), device);
     }
 
     connect(device, SIGNAL(propertyChanged(QString,QVariant)), SLOT(_k_devicePropertyChanged(QString,QVariant)));
+
+    return device;
+}
+
+void Adapter::announceDevice(Device *device)
+{
+    emit deviceFound(device);
+    if (d->m_unpairedDevices.contains(device->addressKey())) {
+        emit unpairedDeviceFound(device);
+    }
 }
 
 void Adapter::removeDevice(const QString &objectPath)
@@ -301,6 +560,59 @@ void Adapter::removeDevice(const QString &objectPath)
     d->_k_deviceRemoved(objectPath);
 }
 
+int Adapter::deviceCount() const
+{
+    return d->m_devicesMapUBIKey.count();
+}
+
+QString Adapter::objectPath() const
+{
+    return d->m_bluezAdapterInterface->path();
+}
+
+void Adapter::updateProperties(const QVariantMap &changed, const QStringList &invalidated)
+{
+    d->_k_propertyChanged(changed, invalidated);
+}
+
+QVariantMap Adapter::cachedProperties() const
+{
+    QVariantMap properties;
+    properties.insert("Address", d->m_address);
+    properties.insert("Name", d->m_name);
+    properties.insert("Alias", d->m_alias);
+    properties.insert("Class", d->m_adapterClass);
+    properties.insert("Powered", d->m_powered);
+    properties.insert("Discoverable", d->m_discoverable);
+    properties.insert("Pairable", d->m_pairable);
+    properties.insert("PairableTimeout", d->m_pairableTimeout);
+    properties.insert("DiscoverableTimeout", d->m_discoverableTimeout);
+    properties.insert("Discovering", d->m_discovering);
+    properties.insert("UUIDs", d->m_UUIDs.UUIDs());
+    properties.insert("Modalias", d->m_modalias);
+    return properties;
+}
+
+void Adapter::queueDeviceChanges(Device *device, quint32 changedMask)
+{
+    emit devicePropertiesChanged(device, changedMask);
+
+    if (d->m_coalescingInterval == -1) {
+        return;
+    }
+
+    if (!d->m_changedDeviceIndexes.contains(device)) {
+        d->m_changedDeviceIndexes.insert(device, d->m_changedDevices.count());
+        d->m_changedDevices << device;
+    }
+    d->m_changedMask |= changedMask;
+
+    // The window starts with the first change, later ones do not delay the batch any further
+    if (!d->m_coalescingTimer.isActive()) {
+        d->m_coalescingTimer.start(d->m_coalescingInterval);
+    }
+}
+
 }
 
 #include "bluedeviladapter.moc"
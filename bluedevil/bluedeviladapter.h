@@ -26,13 +26,17 @@
 #include <bluedevil/bluedevil_export.h>
 
 #include <QtCore/QObject>
+#include <QtCore/QVariant>
 #include <QtDBus/QDBusObjectPath>
 #include <QtDBus/QDBusPendingCallWatcher>
 
 namespace BlueDevil {
 
 class Device;
+class DiscoveryFilter;
 class Manager;
+class OperationScheduler;
+class PendingCall;
 
 /**
  * @class Adapter bluedeviladapter.h bluedevil/bluedeviladapter.h
@@ -62,6 +66,7 @@ class BLUEDEVIL_EXPORT Adapter
     Q_PROPERTY(QList<Device*> unpairedDevices READ unpairedDevices)
     Q_PROPERTY(QList<Device*> devices READ devices)
     Q_PROPERTY(QStringList UUIDs READ UUIDs)
+    Q_PROPERTY(QString modalias READ modalias)
 
     friend class Manager;
     friend class ManagerPrivate;
@@ -131,7 +136,7 @@ public:
     bool isDiscovering() const;
 
     /**
-     * @return A list with all unpaired devices found on the discovery phase.
+     * @return A list with all unpaired devices found on the discovery phase, sorted by address.
      */
     QList<Device*> unpairedDevices() const;
 
@@ -146,8 +151,8 @@ public:
     Device *deviceForUBI(const QString &UBI);
 
     /**
-     * @return All known devices by this adapter. They haven't been necessarily discovered in this
-     *         session.
+     * @return All known devices by this adapter, sorted by address. They haven't been necessarily
+     *         discovered in this session.
      */
     QList<Device*> devices();
 
@@ -156,6 +161,39 @@ public:
      */
     QStringList UUIDs();
 
+    /**
+     * @return Whether this adapter provides the service @p UUID, given either in its 128-bit form
+     *         or as a 16-bit alias like "110b", in any case.
+     */
+    bool hasProfile(const QString &UUID) const;
+
+    /**
+     * @return The BluetoothProfile flags of the well-known services provided by this adapter.
+     */
+    quint32 profiles() const;
+
+    /**
+     * @return The adapter identifier, in the modalias format used by the kernel, or an empty string
+     *         if unknown.
+     */
+    QString modalias() const;
+
+    /**
+     * @return The coalescing window for devicesChanged in milliseconds, or -1 if coalescing is
+     *         disabled, which is the default.
+     */
+    int changeCoalescingInterval() const;
+
+    /**
+     * Enables the devicesChanged signal. Changes to the properties of the devices of this adapter
+     * are accumulated for @p msec milliseconds after the first one, and then reported all at once.
+     * With 0 they are reported when control returns to the event loop. A negative value disables
+     * coalescing, and reports any pending changes right away.
+     *
+     * @note deviceChanged is still emitted for each changed property, regardless of this setting.
+     */
+    void setChangeCoalescingInterval(int msec);
+
 public Q_SLOTS:
     /**
      * Set the name (alias) of the adapter
@@ -198,8 +236,11 @@ public Q_SLOTS:
 
     /**
      * Removes device.
+     *
+     * @return A pending call that will report whether BlueZ removed the device. The deviceRemoved
+     *         signal is emitted independently, once BlueZ announces the removal.
      */
-    void removeDevice(Device *device);
+    PendingCall *removeDevice(Device *device);
 
     /**
      * Starts device discovery. deviceFound signal will be emitted for each device found.
@@ -208,8 +249,10 @@ public Q_SLOTS:
      *       allow the adapter to signal when devices have disappeared when discovering, what could
      *       not be exactly what you want. If the desired behavior is to only be notified of new
      *       discovered devices, please see startStableDiscovery.
+     *
+     * @return A pending call that will report whether the discovery could be started.
      */
-    void startDiscovery() const;
+    PendingCall *startDiscovery() const;
 
     /**
      * Starts device discovery. deviceFound signal will be emitted for each device found.
@@ -217,13 +260,39 @@ public Q_SLOTS:
      * @note This discovery type will never trigger deviceDisappeared signal while discovering, so
      *       you will only get deviceFound signals emitted. This also ensures that you will never get
      *       deviceFound repeated emissions for the same devices, in this sense is more stable.
+     *
+     * @return A pending call that will report whether the discovery could be started.
+     */
+    PendingCall *startStableDiscovery() const;
+
+    /**
+     * Restricts the devices reported while discovering to those matching @p filter. The filter
+     * applies to the discoveries started afterwards by this application, and it is dropped by
+     * BlueZ when discovery stops.
+     *
+     * @return A pending call that will report whether BlueZ accepted the filter.
+     */
+    PendingCall *setDiscoveryFilter(const DiscoveryFilter &filter);
+
+    /**
+     * Removes the discovery filter, so all devices in range will be reported.
+     *
+     * @return A pending call that will report whether the filter was removed.
      */
-    void startStableDiscovery() const;
+    PendingCall *clearDiscoveryFilter();
+
+    /**
+     * @return The scheduler that queues pair, connect and disconnect requests on the devices of
+     *         this adapter. It is owned by this adapter.
+     */
+    OperationScheduler *operationScheduler();
 
     /**
      * Stops device discovery.
+     *
+     * @return A pending call that will report whether the discovery could be stopped.
      */
-    void stopDiscovery() const;
+    PendingCall *stopDiscovery() const;
 
 Q_SIGNALS:
     void deviceRemoved(Device *device);
@@ -236,31 +305,92 @@ Q_SIGNALS:
     void pairableTimeoutChanged(quint32 pairableTimeout);
     void discoverableTimeoutChanged(quint32 discoverableTimeout);
     void deviceChanged(Device* device);
+
+    /**
+     * Emitted once for each batch of property changes that BlueZ reports for @p device, after all
+     * of them have been applied.
+     *
+     * @param changedMask The Device::Property flags of the properties that changed.
+     */
+    void devicePropertiesChanged(Device *device, quint32 changedMask);
+
+    /**
+     * Emitted once per coalescing window with the devices whose properties changed within it,
+     * in the order they first changed. Only emitted if setChangeCoalescingInterval was set.
+     *
+     * @param changedMask The Device::Property flags of the properties that changed, for all
+     *                    devices together.
+     */
+    void devicesChanged(const QList<Device*> &devices, quint32 changedMask);
     void discoveringChanged(bool discovering);
+
+    /**
+     * Emitted for each property that BlueZ changed, named as in org.bluez.Adapter1. @p value is
+     * invalid if BlueZ invalidated the property, which then has its default value.
+     */
     void propertyChanged(const QString &property, const QVariant &value);
 
 private:
     /**
      * @internal
      */
-    Adapter(const QString &adapterPath, QObject *parent = 0);
+    Adapter(const QString &adapterPath, const QVariantMap &properties, QObject *parent = 0);
+
+    /**
+     * @internal
+     *
+     * Creates the device and indexes it. The device is not announced until announceDevice is
+     * called, so the Manager can index it first.
+     */
+    Device *addDevice(const QString &objectPath, const QVariantMap &properties);
 
     /**
      * @internal
      */
-    void addDevice(const QString &objectPath);
+    void announceDevice(Device *device);
 
     /**
      * @internal
      */
     void removeDevice(const QString &objectPath);
 
+    /**
+     * @internal
+     *
+     * Same as devices().count(), without building the list.
+     */
+    int deviceCount() const;
+
+    /**
+     * @internal
+     */
+    QString objectPath() const;
+
+    /**
+     * @internal
+     */
+    void updateProperties(const QVariantMap &changed, const QStringList &invalidated);
+
+    /**
+     * @internal
+     *
+     * @return The cached properties, named as in org.bluez.Adapter1.
+     */
+    QVariantMap cachedProperties() const;
+
+    /**
+     * @internal
+     *
+     * Emits devicePropertiesChanged and queues the changes for devicesChanged.
+     */
+    void queueDeviceChanges(Device *device, quint32 changedMask);
+
     class Private;
     Private *const d;
 
     Q_PRIVATE_SLOT(d, void _k_deviceRemoved(QString))
-    Q_PRIVATE_SLOT(d, void _k_propertyChanged(QString,QVariantMap,QStringList))
     Q_PRIVATE_SLOT(d, void _k_devicePropertyChanged(QString,QVariant))
+    Q_PRIVATE_SLOT(d, void _k_flushDeviceChanges())
 };
 
 }
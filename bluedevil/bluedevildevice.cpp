@@ -22,40 +22,31 @@
 
 #include "bluedevildevice.h"
 #include "bluedeviladapter.h"
+#include "bluedeviloperationscheduler.h"
+#include "bluedevilpendingcall.h"
+#include "bluedevilrssihistory.h"
+#include "bluedevilstatistics_p.h"
+#include "bluedevilutils.h"
+#include "bluedevilutils_p.h"
 
 #include "bluedevil/bluezdevice1.h"
-#include "bluedevil/dbusproperties.h"
 
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMetaMethod>
 #include <QtCore/QString>
-#include <QtCore/QThreadPool>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusVariant>
 
 namespace BlueDevil {
 
-class Task
-    : public QRunnable
-{
-public:
-    Task(Device *device, const char *slot)
-        : m_device(device)
-        , m_slot(slot)
-    {
-    }
-
-    void run() {
-        // We happen to be cool, so asyncCall is called: asyncCall(device, SLOT(method())). This
-        // makes slot to be "1method()", and invokeMethod does not like this, so we have to transform
-        // it to "method".
-        QMetaObject::invokeMethod(m_device, m_slot.mid(1, m_slot.count() - 3).toLatin1().data(), Qt::DirectConnection);
-    }
-
-private:
-    Device  *m_device;
-    QString  m_slot;
-};
-
 void asyncCall(Device *device, const char *slot)
 {
-    QThreadPool::globalInstance()->start(new Task(device, slot));
+    // asyncCall(device, SLOT(method())) gives us "1method()"
+    device->d->asyncCall(QMetaObject::normalizedSignature(slot + 1));
 }
 
 /**
@@ -67,86 +58,380 @@ public:
     Private(BlueDevil::Device *q, const QString &path);
     ~Private();
 
-    void _k_propertyChanged(const QString &interface_name, const QVariantMap &changed_values, const QStringList &invalidated_values);
-    QStringList _k_stringListToUpper(const QStringList & list);
+    typedef void (Private::*PropertySetter)(const QVariant &value, bool notify);
+    struct PropertyHandler {
+        PropertySetter setter;
+        quint32        flag;
+    };
+    typedef QHash<QString, PropertyHandler> PropertyHandlers;
+    static PropertyHandlers createPropertyHandlers();
+    static void addPropertyHandler(PropertyHandlers &handlers, const char *property, PropertySetter setter, quint32 flag);
+
+    org::bluez::Device1 *bluezDevice();
+    void initProperties(const QVariantMap &properties);
+    quint32 setCachedProperty(const QString &property, const QVariant &value, bool notify = false);
+
+    void setAddress(const QVariant &value, bool notify);
+    void setName(const QVariant &value, bool notify);
+    void setAlias(const QVariant &value, bool notify);
+    void setIcon(const QVariant &value, bool notify);
+    void setDeviceClass(const QVariant &value, bool notify);
+    void setPaired(const QVariant &value, bool notify);
+    void setTrusted(const QVariant &value, bool notify);
+    void setBlocked(const QVariant &value, bool notify);
+    void setLegacyPairing(const QVariant &value, bool notify);
+    void setConnected(const QVariant &value, bool notify);
+    void setUUIDs(const QVariant &value, bool notify);
+    void setRSSI(const QVariant &value, bool notify);
+    void setAppearance(const QVariant &value, bool notify);
+    void setModalias(const QVariant &value, bool notify);
+    void updateType();
+    void asyncCall(const QByteArray &method);
+    void _k_propertyFetched(QDBusPendingCallWatcher *watcher);
+    void _k_propertyChanged(const QVariantMap &changed_values, const QStringList &invalidated_values);
 
     org::bluez::Device1                *m_bluezDeviceInterface;
-    org::freedesktop::DBus::Properties *m_dbuspropertiesInterface;
     Adapter                            *m_adapter;
 
     // Bluez cached properties
     bool        m_registrationOnBusRejected; // used for avoid trying to register this device more
                                              // than one time on the bus.
+    QString     m_path;
+    QString     m_address;
+    quint64     m_addressKey; // addressToKey(m_address)
+    QString     m_name;
+    QString     m_alias;
+    QString     m_icon;
+    quint32     m_deviceClass;
+    bool        m_paired;
+    bool        m_trusted;
+    bool        m_blocked;
+    bool        m_legacyPairing;
+    bool        m_connected;
+    UUIDSet     m_UUIDs;
+    qint16      m_RSSI;
+    RSSIHistory m_RSSIHistory;
+    quint16     m_appearance;
+    QString     m_modalias;
+    quint32     m_type; // from m_deviceClass and m_appearance
 
     Device *const m_q;
 };
 
 Device::Private::Private(Device *q, const QString &path)
     : m_bluezDeviceInterface(0)
-    , m_dbuspropertiesInterface(0)
     , m_registrationOnBusRejected(false)
+    , m_path(path)
+    , m_addressKey(0)
+    , m_deviceClass(0)
+    , m_paired(false)
+    , m_trusted(false)
+    , m_blocked(false)
+    , m_legacyPairing(false)
+    , m_connected(false)
+    , m_RSSI(0)
+    , m_appearance(0)
+    , m_type(0)
     , m_q(q)
 {
-  m_bluezDeviceInterface = new org::bluez::Device1("org.bluez",
-                                                        path,
-                                                        QDBusConnection::systemBus(),
-                                                        m_q);
-
-  m_dbuspropertiesInterface = new org::freedesktop::DBus::Properties("org.bluez",path,QDBusConnection::systemBus(),m_q);
 }
 
 Device::Private::~Private()
 {
     delete m_bluezDeviceInterface;
-    delete m_dbuspropertiesInterface;
 }
 
-QStringList Device::Private::_k_stringListToUpper(const QStringList& list)
+org::bluez::Device1 *Device::Private::bluezDevice()
 {
-    QStringList upperList(list);
-    for(int i=0;i<upperList.size();i++) {
-      upperList[i] = upperList.value(i).toUpper();
+    // Most devices are only listed and never acted upon, so the proxy is created on first use
+    if (!m_bluezDeviceInterface) {
+        m_bluezDeviceInterface = new org::bluez::Device1("org.bluez", m_path, QDBusConnection::systemBus(), m_q);
     }
-    return upperList;
+    return m_bluezDeviceInterface;
 }
 
-void Device::Private::_k_propertyChanged(const QString &interface_name, const QVariantMap &changed_values, const QStringList &invalidated_values)
+void Device::Private::initProperties(const QVariantMap &properties)
 {
-  QVariantMap::const_iterator i;
-  for(i = changed_values.constBegin(); i != changed_values.constEnd(); ++i) {
-    QString property = i.key();
-    QVariant value = i.value();
-    if (property == "Paired") {
-        emit m_q->pairedChanged(value.toBool());
+    QVariantMap::const_iterator i;
+    for (i = properties.constBegin(); i != properties.constEnd(); ++i) {
+        setCachedProperty(i.key(), i.value());
+    }
+}
+
+void Device::Private::addPropertyHandler(PropertyHandlers &handlers, const char *property, PropertySetter setter, quint32 flag)
+{
+    PropertyHandler handler;
+    handler.setter = setter;
+    handler.flag = flag;
+    handlers.insert(property, handler);
+}
+
+Device::Private::PropertyHandlers Device::Private::createPropertyHandlers()
+{
+    PropertyHandlers handlers;
+    addPropertyHandler(handlers, "Address", &Private::setAddress, AddressProperty);
+    addPropertyHandler(handlers, "Name", &Private::setName, NameProperty);
+    addPropertyHandler(handlers, "Alias", &Private::setAlias, AliasProperty);
+    addPropertyHandler(handlers, "Icon", &Private::setIcon, IconProperty);
+    addPropertyHandler(handlers, "Class", &Private::setDeviceClass, ClassProperty);
+    addPropertyHandler(handlers, "Paired", &Private::setPaired, PairedProperty);
+    addPropertyHandler(handlers, "Trusted", &Private::setTrusted, TrustedProperty);
+    addPropertyHandler(handlers, "Blocked", &Private::setBlocked, BlockedProperty);
+    addPropertyHandler(handlers, "LegacyPairing", &Private::setLegacyPairing, LegacyPairingProperty);
+    addPropertyHandler(handlers, "Connected", &Private::setConnected, ConnectedProperty);
+    addPropertyHandler(handlers, "UUIDs", &Private::setUUIDs, UUIDsProperty);
+    addPropertyHandler(handlers, "RSSI", &Private::setRSSI, RSSIProperty);
+    addPropertyHandler(handlers, "Appearance", &Private::setAppearance, AppearanceProperty);
+    addPropertyHandler(handlers, "Modalias", &Private::setModalias, ModaliasProperty);
+    return handlers;
+}
+
+quint32 Device::Private::setCachedProperty(const QString &property, const QVariant &value, bool notify)
+{
+    // One hash lookup per property, this is run for every PropertiesChanged of every device. An
+    // invalid value means the property has been invalidated, and the handlers fall back to the
+    // defaults
+    static const PropertyHandlers handlers = createPropertyHandlers();
+
+    const PropertyHandlers::const_iterator it = handlers.constFind(property);
+    if (it == handlers.constEnd()) {
+        return OtherProperty;
+    }
+    (this->*(it->setter))(value, notify);
+    return it->flag;
+}
+
+void Device::Private::setAddress(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_address = value.toString();
+    m_addressKey = addressToKey(m_address);
+}
+
+void Device::Private::setName(const QVariant &value, bool notify)
+{
+    m_name = value.toString();
+    if (notify) {
+        emit m_q->nameChanged(m_name);
+    }
+}
+
+void Device::Private::setAlias(const QVariant &value, bool notify)
+{
+    m_alias = value.toString();
+    if (notify) {
+        emit m_q->aliasChanged(m_alias);
+    }
+}
+
+void Device::Private::setIcon(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_icon = value.toString();
+}
+
+void Device::Private::setDeviceClass(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_deviceClass = value.toUInt();
+    updateType();
+}
+
+void Device::Private::setPaired(const QVariant &value, bool notify)
+{
+    m_paired = value.toBool();
+    if (notify) {
+        emit m_q->pairedChanged(m_paired);
+    }
+}
+
+void Device::Private::setTrusted(const QVariant &value, bool notify)
+{
+    m_trusted = value.toBool();
+    if (notify) {
+        emit m_q->trustedChanged(m_trusted);
+    }
+}
+
+void Device::Private::setBlocked(const QVariant &value, bool notify)
+{
+    m_blocked = value.toBool();
+    if (notify) {
+        emit m_q->blockedChanged(m_blocked);
+    }
+}
+
+void Device::Private::setLegacyPairing(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_legacyPairing = value.toBool();
+}
+
+void Device::Private::setConnected(const QVariant &value, bool notify)
+{
+    m_connected = value.toBool();
+    if (notify) {
+        emit m_q->connectedChanged(m_connected);
+    }
+}
+
+void Device::Private::setUUIDs(const QVariant &value, bool notify)
+{
+    m_UUIDs.setUUIDs(value.toStringList());
+    if (notify) {
+        emit m_q->UUIDsChanged(m_UUIDs.UUIDs());
+    }
+}
+
+void Device::Private::setRSSI(const QVariant &value, bool notify)
+{
+    if (!value.isValid()) {
+        // Out of range, or discovery stopped
+        const bool changed = m_RSSI != 0;
+        m_RSSI = 0;
+        if (notify && changed) {
+            emit m_q->RSSIChanged(m_RSSI);
+        }
+        return;
+    }
+
+    m_RSSI = qint16(value.toInt());
+
+    QElapsedTimer clock;
+    clock.start();
+    m_RSSIHistory.append(clock.msecsSinceReference(), m_RSSI);
+
+    if (notify) {
+        emit m_q->RSSIChanged(m_RSSI);
+    }
+}
+
+void Device::Private::setAppearance(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_appearance = quint16(value.toUInt());
+    updateType();
+}
+
+void Device::Private::setModalias(const QVariant &value, bool notify)
+{
+    Q_UNUSED(notify)
+    m_modalias = value.toString();
+}
+
+void Device::Private::updateType()
+{
+    m_type = classToType(m_deviceClass);
+    if (!m_type) {
+        m_type = appearanceToType(m_appearance);
+    }
+}
+
+void Device::Private::asyncCall(const QByteArray &method)
+{
+    QString property;
+    if (method == "UUIDs()") {
+        property = "UUIDs";
+    } else if (method == "isConnected()") {
+        property = "Connected";
+    } else if (method == "isTrusted()") {
+        property = "Trusted";
+    } else if (method == "isBlocked()") {
+        property = "Blocked";
+    } else if (method == "UBI()") {
+        property = "UBI";
+    }
+
+    if (property.isEmpty()) {
+        // Not a getter, so there is no result to report. Run it from the event loop so the
+        // caller does not wait for it
+        const QMetaObject *const metaObject = m_q->metaObject();
+        const int index = metaObject->indexOfMethod(method);
+        if (index == -1 || !metaObject->method(index).parameterTypes().isEmpty()) {
+            qWarning() << "BlueDevil::asyncCall: cannot call" << method << "asynchronously";
+            return;
+        }
+        metaObject->method(index).invoke(m_q, Qt::QueuedConnection);
+        return;
+    }
+
+    QDBusMessage call = QDBusMessage::createMethodCall("org.bluez", m_path, "org.freedesktop.DBus.Properties", "Get");
+    call << QString("org.bluez.Device1") << property;
+
+    QDBusPendingCall pendingCall;
+    if (property == "UBI") {
+        // The path is not a property, we already know it. Reply right away through the same path
+        pendingCall = QDBusPendingCall::fromCompletedCall(call.createReply(QVariant::fromValue(QDBusVariant(m_path))));
+    } else {
+        pendingCall = QDBusConnection::systemBus().asyncCall(call);
+    }
+
+    QDBusPendingCallWatcher *const watcher = new QDBusPendingCallWatcher(pendingCall, m_q);
+    watcher->setProperty("property", property);
+    if (property != "UBI") {
+        watcher->setProperty("started", statisticsClock());
+        asyncCallStarted();
+    }
+    m_q->connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                 m_q, SLOT(_k_propertyFetched(QDBusPendingCallWatcher*)));
+}
+
+void Device::Private::_k_propertyFetched(QDBusPendingCallWatcher *watcher)
+{
+    const QString property = watcher->property("property").toString();
+    const QDBusPendingReply<QDBusVariant> reply = *watcher;
+    watcher->deleteLater();
+
+    if (property == "UBI") {
+        emit m_q->UBIResult(m_q, m_path);
+        return;
+    }
+
+    recordCall("org.bluez.Device1", property, CallStatistics::GetCall, false,
+               watcher->property("started").toLongLong(), reply.isError());
+
+    // On error we still answer, with what we have cached
+    if (!reply.isError()) {
+        setCachedProperty(property, reply.value().variant());
+    }
+
+    if (property == "UUIDs") {
+        emit m_q->UUIDsResult(m_q, m_UUIDs.UUIDs());
     } else if (property == "Connected") {
-        emit m_q->connectedChanged(value.toBool());
+        emit m_q->isConnectedResult(m_q, m_connected);
     } else if (property == "Trusted") {
-        emit m_q->trustedChanged(value.toBool());
+        emit m_q->isTrustedResult(m_q, m_trusted);
     } else if (property == "Blocked") {
-        emit m_q->blockedChanged(value.toBool());
-    } else if (property == "Alias") {
-        emit m_q->aliasChanged(value.toString());
-    } else if (property == "Name") {
-        emit m_q->nameChanged(value.toString());
-    } else if (property == "UUIDs") {
-        emit m_q->UUIDsChanged(_k_stringListToUpper(value.toStringList()));
+        emit m_q->isBlockedResult(m_q, m_blocked);
     }
-    emit m_q->propertyChanged(property, value);
+}
+
+void Device::Private::_k_propertyChanged(const QVariantMap &changed_values, const QStringList &invalidated_values)
+{
+  quint32 changedMask = 0;
+  Q_FOREACH (const QString &property, invalidated_values) {
+    changedMask |= setCachedProperty(property, QVariant(), true);
+  }
+
+  QVariantMap::const_iterator i;
+  for(i = changed_values.constBegin(); i != changed_values.constEnd(); ++i) {
+    changedMask |= setCachedProperty(i.key(), i.value(), true);
+    emit m_q->propertyChanged(i.key(), i.value());
+  }
+
+  if (changedMask) {
+    m_adapter->queueDeviceChanges(m_q, changedMask);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Device::Device(const QString &path, Adapter *adapter)
+Device::Device(const QString &path, const QVariantMap &properties, Adapter *adapter)
     : QObject(adapter)
     , d(new Private(this,path))
 {
     d->m_adapter = adapter;
-    qRegisterMetaType<BlueDevil::QUInt32StringMap>("BlueDevil::QUInt32StringMap");
-    qDBusRegisterMetaType<BlueDevil::QUInt32StringMap>();
-
-    connect(d->m_dbuspropertiesInterface,SIGNAL(PropertiesChanged(QString,QVariantMap,QStringList)),this,SLOT(_k_propertyChanged(QString,QVariantMap,QStringList)));
-
+    d->initProperties(properties);
 }
 
 Device::~Device()
@@ -154,9 +439,44 @@ Device::~Device()
     delete d;
 }
 
-void Device::pair() const
+void Device::updateProperties(const QVariantMap &changed, const QStringList &invalidated)
+{
+    d->_k_propertyChanged(changed, invalidated);
+}
+
+QVariantMap Device::cachedProperties() const
+{
+    QVariantMap properties;
+    properties.insert("Address", d->m_address);
+    properties.insert("Name", d->m_name);
+    properties.insert("Alias", d->m_alias);
+    properties.insert("Icon", d->m_icon);
+    properties.insert("Class", d->m_deviceClass);
+    properties.insert("Appearance", QVariant::fromValue<ushort>(d->m_appearance));
+    properties.insert("Paired", d->m_paired);
+    properties.insert("Trusted", d->m_trusted);
+    properties.insert("Blocked", d->m_blocked);
+    properties.insert("LegacyPairing", d->m_legacyPairing);
+    properties.insert("Connected", d->m_connected);
+    properties.insert("UUIDs", d->m_UUIDs.UUIDs());
+    properties.insert("RSSI", QVariant::fromValue<short>(d->m_RSSI));
+    properties.insert("Modalias", d->m_modalias);
+    return properties;
+}
+
+quint64 Device::addressKey() const
+{
+    return d->m_addressKey;
+}
+
+PendingCall *Device::pair() const
+{
+    return new PendingCall(d->bluezDevice()->Pair(), "org.bluez.Device1", "Pair", const_cast<Device*>(this));
+}
+
+PendingCall *Device::cancelPairing() const
 {
-    d->m_bluezDeviceInterface->Pair();
+    return new PendingCall(d->bluezDevice()->CancelPairing(), "org.bluez.Device1", "CancelPairing", const_cast<Device*>(this));
 }
 
 Adapter *Device::adapter() const
@@ -166,121 +486,189 @@ Adapter *Device::adapter() const
 
 QString Device::address() const
 {
-    return d->m_bluezDeviceInterface->address();
+    return d->m_address;
 }
 
 QString Device::name() const
 {
-    return d->m_bluezDeviceInterface->name();
+    return d->m_name;
 }
 
 QString Device::friendlyName() const
 {
-    QString alias = d->m_bluezDeviceInterface->alias();
-    QString name = d->m_bluezDeviceInterface->name();
-    if (alias.isEmpty() || alias == name) {
-        return name;
+    if (d->m_alias.isEmpty() || d->m_alias == d->m_name) {
+        return d->m_name;
     }
-    return QString("%1 (%2)").arg(alias).arg(name);
+    return QString("%1 (%2)").arg(d->m_alias).arg(d->m_name);
 }
 
 QString Device::icon() const
 {
-    QString icon = d->m_bluezDeviceInterface->icon();
-    if (icon.isEmpty()) {
+    if (d->m_icon.isEmpty()) {
         return "preferences-system-bluetooth";
     }
-    return icon;
+    return d->m_icon;
 }
 
 quint32 Device::deviceClass() const
 {
-    return d->m_bluezDeviceInterface->deviceClass();
+    return d->m_deviceClass;
+}
+
+quint16 Device::appearance() const
+{
+    return d->m_appearance;
+}
+
+quint32 Device::type() const
+{
+    return d->m_type;
+}
+
+QString Device::modalias() const
+{
+    return d->m_modalias;
 }
 
 bool Device::isPaired() const
 {
-    return d->m_bluezDeviceInterface->paired();
+    return d->m_paired;
 }
 
 QString Device::alias() const
 {
-    return d->m_bluezDeviceInterface->alias();
+    return d->m_alias;
 }
 
 bool Device::hasLegacyPairing() const
 {
-    return d->m_bluezDeviceInterface->legacyPairing();
+    return d->m_legacyPairing;
 }
 
 QStringList Device::UUIDs()
 {
-    QStringList UUIDs = d->_k_stringListToUpper(d->m_bluezDeviceInterface->uUIDs());
-    if (sender()) {
-        emit UUIDsResult(this, UUIDs);
-    }
-    return UUIDs;
+    return d->m_UUIDs.UUIDs();
+}
+
+bool Device::hasProfile(const QString &UUID) const
+{
+    return d->m_UUIDs.contains(UUID);
+}
+
+quint32 Device::profiles() const
+{
+    return d->m_UUIDs.profiles();
 }
 
 QString Device::UBI()
 {
-    const QString path = d->m_bluezDeviceInterface->path();
-    if (sender()) {
-        emit UBIResult(this, path);
-    }
-    return path;
+    return d->m_path;
 }
 
 bool Device::isConnected()
 {
-    bool connected = d->m_bluezDeviceInterface->connected();
-    if (sender()) {
-        emit isConnectedResult(this, connected);
-    }
-    return connected;
+    return d->m_connected;
 }
 
 bool Device::isTrusted()
 {
-    bool trusted = d->m_bluezDeviceInterface->trusted();
-    if (sender()) {
-        emit isTrustedResult(this, trusted);
-    }
-    return trusted;
+    return d->m_trusted;
 }
 
 bool Device::isBlocked()
 {
-    bool blocked = d->m_bluezDeviceInterface->blocked();
-    if (sender()) {
-        emit isBlockedResult(this, blocked);
-    }
-    return blocked;
+    return d->m_blocked;
+}
+
+qint16 Device::RSSI() const
+{
+    return d->m_RSSI;
+}
+
+const RSSIHistory &Device::RSSISamples() const
+{
+    return d->m_RSSIHistory;
+}
+
+void Device::setRSSIHistoryDepth(int depth)
+{
+    d->m_RSSIHistory.setCapacity(depth);
 }
 
 void Device::setTrusted(bool trusted)
 {
-    d->m_bluezDeviceInterface->setTrusted(trusted);
+    SynchronousCall call("org.bluez.Device1", "Trusted", CallStatistics::SetCall);
+    d->bluezDevice()->setTrusted(trusted);
+    call.setFailed(d->bluezDevice()->lastError().isValid());
 }
 
 void Device::setBlocked(bool blocked)
 {
-    d->m_bluezDeviceInterface->setBlocked(blocked);
+    SynchronousCall call("org.bluez.Device1", "Blocked", CallStatistics::SetCall);
+    d->bluezDevice()->setBlocked(blocked);
+    call.setFailed(d->bluezDevice()->lastError().isValid());
 }
 
 void Device::setAlias(const QString &alias)
 {
-    d->m_bluezDeviceInterface->setAlias(alias);
+    SynchronousCall call("org.bluez.Device1", "Alias", CallStatistics::SetCall);
+    d->bluezDevice()->setAlias(alias);
+    call.setFailed(d->bluezDevice()->lastError().isValid());
+}
+
+PendingCall *Device::disconnect()
+{
+    return new PendingCall(d->bluezDevice()->Disconnect(), "org.bluez.Device1", "Disconnect", this);
+}
+
+PendingCall *Device::connectDevice()
+{
+    return new PendingCall(d->bluezDevice()->Connect(), "org.bluez.Device1", "Connect", this);
 }
 
-void Device::disconnect()
+PendingCall *Device::connectProfile(const QString &UUID)
 {
-    d->m_bluezDeviceInterface->Disconnect();
+    return new PendingCall(d->bluezDevice()->ConnectProfile(UUID), "org.bluez.Device1", "ConnectProfile", this);
 }
 
-void Device::connectDevice()
+PendingCall *Device::disconnectProfile(const QString &UUID)
 {
-    d->m_bluezDeviceInterface->Connect();
+    return new PendingCall(d->bluezDevice()->DisconnectProfile(UUID), "org.bluez.Device1", "DisconnectProfile", this);
+}
+
+QDBusPendingCall Device::callOperation(int operation, const QString &UUID, int timeout, const char **member)
+{
+    org::bluez::Device1 *const device = d->bluezDevice();
+
+    // The timeout is read when the message is sent, so it only applies to this call
+    device->setTimeout(timeout);
+    QDBusPendingCall call = QDBusPendingCall::fromError(QDBusError(QDBusError::InvalidArgs,
+                                                                   QLatin1String("Unknown operation")));
+    switch (operation) {
+    case OperationScheduler::PairOperation:
+        call = device->Pair();
+        *member = "Pair";
+        break;
+    case OperationScheduler::ConnectOperation:
+        call = device->Connect();
+        *member = "Connect";
+        break;
+    case OperationScheduler::DisconnectOperation:
+        call = device->Disconnect();
+        *member = "Disconnect";
+        break;
+    case OperationScheduler::ConnectProfileOperation:
+        call = device->ConnectProfile(UUID);
+        *member = "ConnectProfile";
+        break;
+    case OperationScheduler::DisconnectProfileOperation:
+        call = device->DisconnectProfile(UUID);
+        *member = "DisconnectProfile";
+        break;
+    }
+    device->setTimeout(-1);
+
+    return call;
 }
 
 }
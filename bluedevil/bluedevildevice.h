@@ -30,11 +30,17 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 #include <QtDBus/QDBusObjectPath>
 
+class QDBusPendingCall;
+class QDBusPendingCallWatcher;
+
 namespace BlueDevil {
 
 class Device;
+class PendingCall;
+class RSSIHistory;
 
 /**
  * Generates an asynchronous call on any method of the Device class. Only some methods allow the
@@ -51,8 +57,11 @@ class Device;
  * We will later receive on our deviceRegistered slot the information when the fetching of
  * information has finished.
  *
- * @warning Only documented methods (they are always slots) can be called asynchronously. They have
- *          been carefully chosen beforehand for those which are blocking.
+ * The getters are answered by fetching the property from BlueZ without blocking, and the result
+ * signal is emitted from the event loop of the thread @p device lives in, which is also the thread
+ * this function has to be called from. Slots without arguments are invoked from the event loop.
+ *
+ * @warning Only documented methods can be called asynchronously.
  */
 void BLUEDEVIL_EXPORT asyncCall(Device *device, const char *slot);
 
@@ -72,16 +81,14 @@ class Adapter;
  * on the bus). This properties that do not need connection are explicitly marked on their
  * respective documentation.
  *
- * Since this values are cached, you will not get updates on their state until you make a call that
- * forces the device to be registered on the bus (and thus, created, in D-Bus terminology), or you
- * explicitly call to registerDevice.
- *
- * After the Device has been registered, it will automatically update its properties internally, and
- * additionally signals like pairedChanged will be emitted when this properties are updated.
+ * All properties are cached locally. The cache is filled with the properties BlueZ reports when the
+ * device is announced, and it is kept up to date from the PropertiesChanged signal, so reading a
+ * property never results in a D-Bus call. Signals like pairedChanged will be emitted when this
+ * properties are updated.
  *
- * Please note that since some functions here are blocking, there exists a way to asynchronous
- * perform certain operations that are known to be expensive. This way your GUI will not block
- * itself when waiting for a response from the remote device.
+ * If you need the current value from BlueZ instead of the cached one, some properties can be
+ * fetched asynchronously through asyncCall. This way your GUI will not block itself when waiting
+ * for a response.
  *
  * @author Rafael Fernández López <ereslibre@kde.org>
  */
@@ -104,20 +111,60 @@ class BLUEDEVIL_EXPORT Device
     Q_PROPERTY(bool isConnected READ isConnected)
     Q_PROPERTY(bool trusted READ isTrusted WRITE setTrusted)
     Q_PROPERTY(bool blocked READ isBlocked WRITE setBlocked)
+    Q_PROPERTY(qint16 RSSI READ RSSI)
+    Q_PROPERTY(quint16 appearance READ appearance)
+    Q_PROPERTY(QString modalias READ modalias)
+    Q_PROPERTY(quint32 type READ type)
 
     friend class Adapter;
     friend class Manager;
+    friend class ManagerPrivate;
+    friend class OperationScheduler;
+    friend void asyncCall(Device *device, const char *slot);
 
 public:
+    /**
+     * Properties of a remote device, as flags. They are used to report which properties changed,
+     * see Adapter::devicesChanged.
+     */
+    enum Property {
+        AddressProperty       = 0x00000001,
+        NameProperty          = 0x00000002,
+        AliasProperty         = 0x00000004,
+        IconProperty          = 0x00000008,
+        ClassProperty         = 0x00000010,
+        PairedProperty        = 0x00000020,
+        TrustedProperty       = 0x00000040,
+        BlockedProperty       = 0x00000080,
+        LegacyPairingProperty = 0x00000100,
+        ConnectedProperty     = 0x00000200,
+        UUIDsProperty         = 0x00000400,
+        RSSIProperty          = 0x00000800,
+        AppearanceProperty    = 0x00001000,
+        ModaliasProperty      = 0x00002000,
+        OtherProperty         = 0x80000000 ///< Any property that has no flag of its own
+    };
+
     virtual ~Device();
 
     /**
      * Starts the pairing process, the pairedChanged signal will be emitted if succeeded.
      *
+     * @return A pending call that will report whether the pairing succeeded. It is owned by this
+     *         device and deletes itself when finished.
+     *
      * @note If the device is registered moments before this function is called, then it might
      *       do not work in some devices.
      */
-    void pair() const;
+    PendingCall *pair() const;
+
+    /**
+     * Cancels a pairing process started with pair().
+     *
+     * @return A pending call that will report whether there was a pairing to cancel. It is owned
+     *         by this device and deletes itself when finished.
+     */
+    PendingCall *cancelPairing() const;
 
     /**
      * @return The adapter that discovered this remote device.
@@ -165,6 +212,31 @@ public:
      */
     quint32 deviceClass() const;
 
+    /**
+     * @return The external appearance of the remote device, as defined by the GAP Appearance
+     *         characteristic, or 0 if unknown. LE devices report it instead of a class.
+     *
+     * @note This request will not trigger a connection to the device.
+     */
+    quint16 appearance() const;
+
+    /**
+     * @return The type of the remote device as a BluetoothType flag, or 0 if unknown. It is worked
+     *         out from the class of the device, or from its appearance if the class is unknown.
+     *
+     * @note The type is only recomputed when the class or the appearance change, so this is
+     *       cheap enough to be called when filtering lists of devices.
+     */
+    quint32 type() const;
+
+    /**
+     * @return The remote device identifier, in the modalias format used by the kernel, as in
+     *         "usb:v1D6Bp0246d0535", or an empty string if unknown.
+     *
+     * @note This request will not trigger a connection to the device.
+     */
+    QString modalias() const;
+
     /**
      * @return Whether this remote device is paired or not.
      *
@@ -189,20 +261,34 @@ public:
     /**
      * @return The list of supported services by the remote device always in uppercase.
      *
-     * @note This request will trigger a connection to the device with the consequent registration
-     *       on the bus.
+     * @note This request will not trigger a connection to the device.
      *
      * @note Allows being called with the asynchronous API through asyncCall. UUIDsResult signal
      *       will be emitted with the result.
      */
     QStringList UUIDs();
 
+    /**
+     * @return Whether the remote device provides the service @p UUID, given either in its 128-bit
+     *         form or as a 16-bit alias like "110b", in any case.
+     *
+     * @note This request will not trigger a connection to the device.
+     */
+    bool hasProfile(const QString &UUID) const;
+
+    /**
+     * @return The BluetoothProfile flags of the well-known services provided by the remote
+     *         device, so that several of them can be tested at once.
+     *
+     * @note This request will not trigger a connection to the device.
+     */
+    quint32 profiles() const;
+
     /**
      * @return UBI for this device. In case that the connection with the device fails, an empty
      *         string will be returned.
      *
-     * @note This request will trigger a connection to the device with the consequent registration
-     *       on the bus.
+     * @note This request will not trigger a connection to the device.
      *
      * @note Allows being called with the asynchronous API through asyncCall. UBIResult signal
      *       will be emitted with the result.
@@ -212,8 +298,7 @@ public:
     /**
      * @return Whether this remote device is connected or not.
      *
-     * @note This request will trigger a connection to the device with the consequent registration
-     *       on the bus.
+     * @note This request will not trigger a connection to the device.
      *
      * @note Allows being called with the asynchronous API through asyncCall. isConnectedResult
      *       signal will be emitted with the result.
@@ -223,8 +308,7 @@ public:
     /**
      * @return Whether this remote device is trusted or not.
      *
-     * @note This request will trigger a connection to the device with the consequent registration
-     *       on the bus.
+     * @note This request will not trigger a connection to the device.
      *
      * @note Allows being called with the asynchronous API through asyncCall. isTrustedResult
      *       signal will be emitted with the result.
@@ -234,14 +318,33 @@ public:
     /**
      * @return Whether this remote device is blocked or not.
      *
-     * @note This request will trigger a connection to the device with the consequent registration
-     *       on the bus.
+     * @note This request will not trigger a connection to the device.
      *
      * @note Allows being called with the asynchronous API through asyncCall. isBlockedResult
      *       signal will be emitted with the result.
      */
     bool isBlocked();
 
+    /**
+     * @return The signal strength of the remote device in dBm, as last reported by BlueZ, or 0
+     *         if it has not been reported. BlueZ only reports it while discovering.
+     *
+     * @note This request will not trigger a connection to the device.
+     */
+    qint16 RSSI() const;
+
+    /**
+     * @return The latest signal strength readings of the remote device. No samples are kept
+     *         unless setRSSIHistoryDepth is called, but the latest reading and the exponential
+     *         average always are.
+     */
+    const RSSIHistory &RSSISamples() const;
+
+    /**
+     * Sets how many signal strength readings are kept in RSSISamples. 0 by default.
+     */
+    void setRSSIHistoryDepth(int depth);
+
 public Q_SLOTS:
     /**
      * Sets whether this remote device is trusted or not.
@@ -276,14 +379,34 @@ public Q_SLOTS:
     /**
      * Disconnect from this remote device.
      *
+     * @return A pending call that will report whether the device was disconnected.
+     *
      * @note Allows being called with the asynchronous API through asyncCall.
      */
-    void disconnect();
+    PendingCall *disconnect();
 
     /**
      * Connect all profiles marked auto-connectable of this device.
+     *
+     * @return A pending call that will report whether the device was connected.
      */
-    void connectDevice();
+    PendingCall *connectDevice();
+
+    /**
+     * Connect only the profile @p UUID of this device. This is faster than connectDevice when
+     * just one profile is needed, as BlueZ does not try the other ones in turn.
+     *
+     * @return A pending call that will report whether the profile was connected. It fails with
+     *         org.bluez.Error.InvalidArguments if the device does not provide the profile.
+     */
+    PendingCall *connectProfile(const QString &UUID);
+
+    /**
+     * Disconnect only the profile @p UUID of this device, keeping the other ones connected.
+     *
+     * @return A pending call that will report whether the profile was disconnected.
+     */
+    PendingCall *disconnectProfile(const QString &UUID);
 
 Q_SIGNALS:
     void pairedChanged(bool paired);
@@ -293,6 +416,7 @@ Q_SIGNALS:
     void aliasChanged(const QString &alias);
     void nameChanged(const QString &name);
     void UUIDsChanged(const QStringList &UUIDs);
+    void RSSIChanged(qint16 RSSI);
     void propertyChanged(const QString &property, const QVariant &value);
     void disconnectRequested();
 
@@ -310,12 +434,40 @@ private:
     /**
      * @internal
      */
-    Device(const QString &path, Adapter *adapter);
+    Device(const QString &path, const QVariantMap &properties, Adapter *adapter);
+
+    /**
+     * @internal
+     */
+    void updateProperties(const QVariantMap &changed, const QStringList &invalidated);
+
+    /**
+     * @internal
+     *
+     * @return The cached properties, named as in org.bluez.Device1.
+     */
+    QVariantMap cachedProperties() const;
+
+    /**
+     * @internal
+     *
+     * @return The address packed by addressToKey, which the adapter indexes and orders devices by.
+     */
+    quint64 addressKey() const;
+
+    /**
+     * @internal
+     *
+     * Sends @p operation, an OperationScheduler::Operation, through the device proxy with a
+     * timeout of @p timeout milliseconds, or the D-Bus default one if -1. @p member is set to
+     * the name of the method that was called.
+     */
+    QDBusPendingCall callOperation(int operation, const QString &UUID, int timeout, const char **member);
 
     class Private;
     Private *const d;
 
-    Q_PRIVATE_SLOT(d, void _k_propertyChanged(QString,QVariantMap,QStringList))
+    Q_PRIVATE_SLOT(d, void _k_propertyFetched(QDBusPendingCallWatcher*))
 };
 
 }
@@ -0,0 +1,346 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevildeviceview.h"
+#include "bluedeviladapter.h"
+#include "bluedevildevice.h"
+#include "bluedevilmanager.h"
+
+#include <QtCore/QSet>
+
+namespace BlueDevil {
+
+DevicePredicate::~DevicePredicate()
+{
+}
+
+quint32 DevicePredicate::dependencies() const
+{
+    return 0xffffffff;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DevicePropertyPredicate::DevicePropertyPredicate()
+    : m_required(0)
+    , m_paired(false)
+    , m_connected(false)
+    , m_trusted(false)
+    , m_types(0)
+    , m_profiles(0)
+{
+}
+
+DevicePropertyPredicate::~DevicePropertyPredicate()
+{
+}
+
+void DevicePropertyPredicate::requirePaired(bool paired)
+{
+    m_required |= Device::PairedProperty;
+    m_paired = paired;
+}
+
+void DevicePropertyPredicate::requireConnected(bool connected)
+{
+    m_required |= Device::ConnectedProperty;
+    m_connected = connected;
+}
+
+void DevicePropertyPredicate::requireTrusted(bool trusted)
+{
+    m_required |= Device::TrustedProperty;
+    m_trusted = trusted;
+}
+
+void DevicePropertyPredicate::requireTypes(quint32 types)
+{
+    m_required |= Device::ClassProperty | Device::AppearanceProperty;
+    m_types = types;
+}
+
+void DevicePropertyPredicate::requireProfiles(quint32 profiles)
+{
+    m_required |= Device::UUIDsProperty;
+    m_profiles = profiles;
+}
+
+bool DevicePropertyPredicate::accepts(Device *device) const
+{
+    if ((m_required & Device::PairedProperty) && device->isPaired() != m_paired) {
+        return false;
+    }
+    if ((m_required & Device::ConnectedProperty) && device->isConnected() != m_connected) {
+        return false;
+    }
+    if ((m_required & Device::TrustedProperty) && device->isTrusted() != m_trusted) {
+        return false;
+    }
+    if ((m_required & Device::ClassProperty) && !(device->type() & m_types)) {
+        return false;
+    }
+    if ((m_required & Device::UUIDsProperty) && (device->profiles() & m_profiles) != m_profiles) {
+        return false;
+    }
+    return true;
+}
+
+quint32 DevicePropertyPredicate::dependencies() const
+{
+    return m_required;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @internal
+ */
+class DeviceView::Private
+{
+public:
+    Private(DeviceView *q, Adapter *adapter, DevicePredicate *predicate);
+    ~Private();
+
+    void watchAdapter(Adapter *adapter, bool notify);
+    bool accepts(Device *device) const;
+    void insert(Device *device);
+    void remove(Device *device);
+
+    void _k_adapterAdded(Adapter *adapter);
+    void _k_adapterDestroyed(QObject *object);
+    void _k_deviceFound(Device *device);
+    void _k_deviceRemoved(Device *device);
+    void _k_devicePropertiesChanged(Device *device, quint32 changedMask);
+
+    Adapter         *m_adapter;
+    QList<Adapter*>  m_adapters;  // watched adapters
+    DevicePredicate *m_predicate;
+    QList<Device*>   m_devices;   // in the order they entered the view
+    QSet<Device*>    m_members;
+
+    DeviceView *const m_q;
+};
+
+DeviceView::Private::Private(DeviceView *q, Adapter *adapter, DevicePredicate *predicate)
+    : m_adapter(adapter)
+    , m_predicate(predicate)
+    , m_q(q)
+{
+}
+
+DeviceView::Private::~Private()
+{
+    delete m_predicate;
+}
+
+void DeviceView::Private::watchAdapter(Adapter *adapter, bool notify)
+{
+    m_adapters << adapter;
+    m_q->connect(adapter, SIGNAL(destroyed(QObject*)), m_q, SLOT(_k_adapterDestroyed(QObject*)));
+    m_q->connect(adapter, SIGNAL(deviceFound(Device*)), m_q, SLOT(_k_deviceFound(Device*)));
+    m_q->connect(adapter, SIGNAL(deviceRemoved(Device*)), m_q, SLOT(_k_deviceRemoved(Device*)));
+    m_q->connect(adapter, SIGNAL(devicePropertiesChanged(Device*,quint32)),
+                 m_q, SLOT(_k_devicePropertiesChanged(Device*,quint32)));
+
+    Q_FOREACH (Device *device, adapter->devices()) {
+        if (accepts(device)) {
+            insert(device);
+            if (notify) {
+                emit m_q->deviceInserted(device);
+            }
+        }
+    }
+}
+
+bool DeviceView::Private::accepts(Device *device) const
+{
+    return !m_predicate || m_predicate->accepts(device);
+}
+
+void DeviceView::Private::insert(Device *device)
+{
+    m_members.insert(device);
+    m_devices << device;
+}
+
+void DeviceView::Private::remove(Device *device)
+{
+    m_members.remove(device);
+    m_devices.removeOne(device);
+}
+
+void DeviceView::Private::_k_adapterAdded(Adapter *adapter)
+{
+    watchAdapter(adapter, true);
+}
+
+void DeviceView::Private::_k_adapterDestroyed(QObject *object)
+{
+    // The devices of the adapter are deleted right after, without being removed one by one
+    Q_FOREACH (Device *device, m_devices) {
+        if (static_cast<QObject*>(device->adapter()) == object) {
+            remove(device);
+            emit m_q->deviceRemoved(device);
+        }
+    }
+
+    for (int i = 0; i < m_adapters.count(); ++i) {
+        if (static_cast<QObject*>(m_adapters.at(i)) == object) {
+            m_adapters.removeAt(i);
+            break;
+        }
+    }
+    if (static_cast<QObject*>(m_adapter) == object) {
+        m_adapter = 0;
+    }
+}
+
+void DeviceView::Private::_k_deviceFound(Device *device)
+{
+    if (!m_members.contains(device) && accepts(device)) {
+        insert(device);
+        emit m_q->deviceInserted(device);
+    }
+}
+
+void DeviceView::Private::_k_deviceRemoved(Device *device)
+{
+    if (m_members.contains(device)) {
+        remove(device);
+        emit m_q->deviceRemoved(device);
+    }
+}
+
+void DeviceView::Private::_k_devicePropertiesChanged(Device *device, quint32 changedMask)
+{
+    const bool member = m_members.contains(device);
+
+    if (m_predicate && (changedMask & m_predicate->dependencies())) {
+        const bool accepted = m_predicate->accepts(device);
+        if (accepted && !member) {
+            insert(device);
+            emit m_q->deviceInserted(device);
+            return;
+        }
+        if (!accepted && member) {
+            remove(device);
+            emit m_q->deviceRemoved(device);
+            return;
+        }
+    }
+
+    if (member) {
+        emit m_q->deviceChanged(device, changedMask);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeviceView::DeviceView(Adapter *adapter, DevicePredicate *predicate, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, adapter, predicate))
+{
+    if (adapter) {
+        d->watchAdapter(adapter, false);
+    }
+}
+
+DeviceView::DeviceView(DevicePredicate *predicate, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, 0, predicate))
+{
+    Manager *const manager = Manager::self();
+    connect(manager, SIGNAL(adapterAdded(Adapter*)), this, SLOT(_k_adapterAdded(Adapter*)));
+    Q_FOREACH (Adapter *adapter, manager->adapters()) {
+        d->watchAdapter(adapter, false);
+    }
+}
+
+DeviceView::~DeviceView()
+{
+    delete d;
+}
+
+Adapter *DeviceView::adapter() const
+{
+    return d->m_adapter;
+}
+
+DevicePredicate *DeviceView::predicate() const
+{
+    return d->m_predicate;
+}
+
+void DeviceView::setPredicate(DevicePredicate *predicate)
+{
+    if (predicate == d->m_predicate) {
+        return;
+    }
+    delete d->m_predicate;
+    d->m_predicate = predicate;
+    refilter();
+}
+
+void DeviceView::refilter()
+{
+    Q_FOREACH (Device *device, d->m_devices) {
+        if (!d->accepts(device)) {
+            d->remove(device);
+            emit deviceRemoved(device);
+        }
+    }
+
+    Q_FOREACH (Adapter *adapter, d->m_adapters) {
+        Q_FOREACH (Device *device, adapter->devices()) {
+            if (!d->m_members.contains(device) && d->accepts(device)) {
+                d->insert(device);
+                emit deviceInserted(device);
+            }
+        }
+    }
+}
+
+int DeviceView::count() const
+{
+    return d->m_devices.count();
+}
+
+bool DeviceView::isEmpty() const
+{
+    return d->m_devices.isEmpty();
+}
+
+bool DeviceView::contains(Device *device) const
+{
+    return d->m_members.contains(device);
+}
+
+Device *DeviceView::at(int index) const
+{
+    return d->m_devices.at(index);
+}
+
+const QList<Device*> &DeviceView::devices() const
+{
+    return d->m_devices;
+}
+
+}
+
+#include "bluedevildeviceview.moc"
@@ -0,0 +1,186 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILDEVICEVIEW_H
+#define BLUEDEVILDEVICEVIEW_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+
+namespace BlueDevil {
+
+class Adapter;
+class Device;
+
+/**
+ * @class DevicePredicate bluedevildeviceview.h bluedevil/bluedevildeviceview.h
+ *
+ * Decides which devices belong to a DeviceView. accepts should only look at the cached properties
+ * of the device, as it is called again every time one of them changes.
+ */
+class BLUEDEVIL_EXPORT DevicePredicate
+{
+public:
+    virtual ~DevicePredicate();
+
+    /**
+     * @return Whether @p device belongs to the view.
+     */
+    virtual bool accepts(Device *device) const = 0;
+
+    /**
+     * @return The Device::Property flags of the properties accepts looks at. Changes to other
+     *         properties do not make the view call accepts again. All of them by default.
+     */
+    virtual quint32 dependencies() const;
+};
+
+/**
+ * @class DevicePropertyPredicate bluedevildeviceview.h bluedevil/bluedevildeviceview.h
+ *
+ * A DevicePredicate for the common cases. A device is accepted if it matches all of the
+ * requirements that have been set, so a default constructed one accepts every device.
+ */
+class BLUEDEVIL_EXPORT DevicePropertyPredicate
+    : public DevicePredicate
+{
+public:
+    DevicePropertyPredicate();
+    virtual ~DevicePropertyPredicate();
+
+    void requirePaired(bool paired);
+    void requireConnected(bool connected);
+    void requireTrusted(bool trusted);
+
+    /**
+     * Only accepts devices whose type is one of the BluetoothType flags in @p types.
+     */
+    void requireTypes(quint32 types);
+
+    /**
+     * Only accepts devices that provide all of the BluetoothProfile flags in @p profiles.
+     */
+    void requireProfiles(quint32 profiles);
+
+    virtual bool accepts(Device *device) const;
+    virtual quint32 dependencies() const;
+
+private:
+    quint32 m_required;
+    bool    m_paired;
+    bool    m_connected;
+    bool    m_trusted;
+    quint32 m_types;
+    quint32 m_profiles;
+};
+
+/**
+ * @class DeviceView bluedevildeviceview.h bluedevil/bluedevildeviceview.h
+ *
+ * The devices of an adapter, or of all adapters, that a DevicePredicate accepts. The view keeps
+ * itself up to date as devices are found, removed or change, and only evaluates the predicate for
+ * the device that changed, so it costs nothing while nothing happens:
+ *
+ * @code
+ * DevicePropertyPredicate *predicate = new DevicePropertyPredicate;
+ * predicate->requireConnected(true);
+ * predicate->requireProfiles(BLUETOOTH_PROFILE_A2DP_SINK);
+ * DeviceView *view = new DeviceView(adapter, predicate, this);
+ * connect(view, SIGNAL(deviceInserted(Device*)), this, SLOT(addSpeaker(Device*)));
+ * connect(view, SIGNAL(deviceRemoved(Device*)), this, SLOT(removeSpeaker(Device*)));
+ * @endcode
+ *
+ * The devices are kept in the order they entered the view.
+ */
+class BLUEDEVIL_EXPORT DeviceView
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates a view of the devices of @p adapter. It takes ownership of @p predicate. If
+     * @p predicate is 0, the view holds all the devices.
+     */
+    DeviceView(Adapter *adapter, DevicePredicate *predicate = 0, QObject *parent = 0);
+
+    /**
+     * Creates a view of the devices of all the adapters known by the Manager, including those
+     * added later on.
+     */
+    explicit DeviceView(DevicePredicate *predicate = 0, QObject *parent = 0);
+
+    virtual ~DeviceView();
+
+    /**
+     * @return The adapter this view is restricted to, or 0 if it covers all of them.
+     */
+    Adapter *adapter() const;
+
+    DevicePredicate *predicate() const;
+
+    /**
+     * Replaces the predicate, deleting the previous one, and refilters the view.
+     */
+    void setPredicate(DevicePredicate *predicate);
+
+    /**
+     * Evaluates the predicate again for all the devices. Only needed when the criteria of the
+     * predicate itself have changed.
+     */
+    void refilter();
+
+    int count() const;
+    bool isEmpty() const;
+    bool contains(Device *device) const;
+    Device *at(int index) const;
+    const QList<Device*> &devices() const;
+
+Q_SIGNALS:
+    void deviceInserted(Device *device);
+
+    /**
+     * Emitted when @p device leaves the view, either because it no longer matches or because
+     * it went away. In the latter case the device is deleted right after.
+     */
+    void deviceRemoved(Device *device);
+
+    /**
+     * Emitted when properties of a device in the view change and it still belongs to it.
+     *
+     * @param changedMask The Device::Property flags of the properties that changed.
+     */
+    void deviceChanged(Device *device, quint32 changedMask);
+
+private:
+    class Private;
+    Private *const d;
+
+    Q_PRIVATE_SLOT(d, void _k_adapterAdded(Adapter*))
+    Q_PRIVATE_SLOT(d, void _k_adapterDestroyed(QObject*))
+    Q_PRIVATE_SLOT(d, void _k_deviceFound(Device*))
+    Q_PRIVATE_SLOT(d, void _k_deviceRemoved(Device*))
+    Q_PRIVATE_SLOT(d, void _k_devicePropertiesChanged(Device*,quint32))
+};
+
+}
+
+#endif // BLUEDEVILDEVICEVIEW_H
@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevildiscoveryfilter.h"
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ */
+class DiscoveryFilter::Private
+    : public QSharedData
+{
+public:
+    Private();
+
+    DiscoveryFilter::Transport m_transport;
+    bool                       m_hasRSSI;
+    qint16                     m_RSSI;
+    bool                       m_hasPathloss;
+    quint16                    m_pathloss;
+    QStringList                m_UUIDs;
+    bool                       m_duplicateData;
+};
+
+DiscoveryFilter::Private::Private()
+    : m_transport(DiscoveryFilter::AutoTransport)
+    , m_hasRSSI(false)
+    , m_RSSI(0)
+    , m_hasPathloss(false)
+    , m_pathloss(0)
+    , m_duplicateData(true)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DiscoveryFilter::DiscoveryFilter()
+    : d(new Private)
+{
+}
+
+DiscoveryFilter::DiscoveryFilter(const DiscoveryFilter &other)
+    : d(other.d)
+{
+}
+
+DiscoveryFilter::~DiscoveryFilter()
+{
+}
+
+DiscoveryFilter &DiscoveryFilter::operator=(const DiscoveryFilter &other)
+{
+    d = other.d;
+    return *this;
+}
+
+bool DiscoveryFilter::operator==(const DiscoveryFilter &other) const
+{
+    return d->m_transport == other.d->m_transport &&
+           d->m_hasRSSI == other.d->m_hasRSSI &&
+           d->m_RSSI == other.d->m_RSSI &&
+           d->m_hasPathloss == other.d->m_hasPathloss &&
+           d->m_pathloss == other.d->m_pathloss &&
+           d->m_UUIDs == other.d->m_UUIDs &&
+           d->m_duplicateData == other.d->m_duplicateData;
+}
+
+bool DiscoveryFilter::operator!=(const DiscoveryFilter &other) const
+{
+    return !(*this == other);
+}
+
+bool DiscoveryFilter::isEmpty() const
+{
+    return *this == DiscoveryFilter();
+}
+
+DiscoveryFilter::Transport DiscoveryFilter::transport() const
+{
+    return d->m_transport;
+}
+
+void DiscoveryFilter::setTransport(Transport transport)
+{
+    d->m_transport = transport;
+}
+
+bool DiscoveryFilter::hasRSSI() const
+{
+    return d->m_hasRSSI;
+}
+
+qint16 DiscoveryFilter::RSSI() const
+{
+    return d->m_RSSI;
+}
+
+void DiscoveryFilter::setRSSI(qint16 RSSI)
+{
+    d->m_hasRSSI = true;
+    d->m_RSSI = RSSI;
+    d->m_hasPathloss = false;
+    d->m_pathloss = 0;
+}
+
+bool DiscoveryFilter::hasPathloss() const
+{
+    return d->m_hasPathloss;
+}
+
+quint16 DiscoveryFilter::pathloss() const
+{
+    return d->m_pathloss;
+}
+
+void DiscoveryFilter::setPathloss(quint16 pathloss)
+{
+    d->m_hasPathloss = true;
+    d->m_pathloss = pathloss;
+    d->m_hasRSSI = false;
+    d->m_RSSI = 0;
+}
+
+QStringList DiscoveryFilter::UUIDs() const
+{
+    return d->m_UUIDs;
+}
+
+void DiscoveryFilter::setUUIDs(const QStringList &UUIDs)
+{
+    d->m_UUIDs = UUIDs;
+}
+
+bool DiscoveryFilter::duplicateData() const
+{
+    return d->m_duplicateData;
+}
+
+void DiscoveryFilter::setDuplicateData(bool duplicateData)
+{
+    d->m_duplicateData = duplicateData;
+}
+
+QVariantMap DiscoveryFilter::toVariantMap() const
+{
+    // Older BlueZ versions reject the keys they do not know, like DuplicateData, so the defaults
+    // are left out
+    QVariantMap filter;
+    switch (d->m_transport) {
+        case BrEdrTransport:
+            filter.insert("Transport", QString("bredr"));
+            break;
+        case LeTransport:
+            filter.insert("Transport", QString("le"));
+            break;
+        default:
+            break;
+    }
+    if (d->m_hasRSSI) {
+        filter.insert("RSSI", QVariant::fromValue<qint16>(d->m_RSSI));
+    }
+    if (d->m_hasPathloss) {
+        filter.insert("Pathloss", QVariant::fromValue<quint16>(d->m_pathloss));
+    }
+    if (!d->m_UUIDs.isEmpty()) {
+        filter.insert("UUIDs", d->m_UUIDs);
+    }
+    if (!d->m_duplicateData) {
+        filter.insert("DuplicateData", false);
+    }
+    return filter;
+}
+
+}
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILDISCOVERYFILTER_H
+#define BLUEDEVILDISCOVERYFILTER_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QSharedDataPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+
+namespace BlueDevil {
+
+/**
+ * @class DiscoveryFilter bluedevildiscoveryfilter.h bluedevil/bluedevildiscoveryfilter.h
+ *
+ * Criteria for the devices an adapter reports while discovering. The filtering is done by BlueZ
+ * and the controller, so devices that do not match are never announced to us.
+ *
+ * A default constructed filter has no criteria, every device matches it.
+ *
+ * @code
+ * DiscoveryFilter filter;
+ * filter.setTransport(DiscoveryFilter::LeTransport);
+ * filter.setRSSI(-70);
+ * adapter->setDiscoveryFilter(filter);
+ * adapter->startDiscovery();
+ * @endcode
+ *
+ * @see Adapter::setDiscoveryFilter
+ */
+class BLUEDEVIL_EXPORT DiscoveryFilter
+{
+public:
+    enum Transport {
+        AutoTransport = 0, ///< Interleaved scan, or whatever the adapter supports
+        BrEdrTransport,    ///< Only BR/EDR inquiry
+        LeTransport        ///< Only LE scan
+    };
+
+    DiscoveryFilter();
+    DiscoveryFilter(const DiscoveryFilter &other);
+    ~DiscoveryFilter();
+
+    DiscoveryFilter &operator=(const DiscoveryFilter &other);
+    bool operator==(const DiscoveryFilter &other) const;
+    bool operator!=(const DiscoveryFilter &other) const;
+
+    /**
+     * @return Whether this filter has no criteria.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @return The transport to discover devices on. AutoTransport by default.
+     */
+    Transport transport() const;
+    void setTransport(Transport transport);
+
+    /**
+     * @return Whether there is an RSSI threshold. It is exclusive with the pathloss threshold.
+     */
+    bool hasRSSI() const;
+
+    /**
+     * @return The RSSI threshold in dBm. Only devices with a stronger signal are reported.
+     */
+    qint16 RSSI() const;
+
+    /**
+     * Sets the RSSI threshold, and removes the pathloss threshold.
+     */
+    void setRSSI(qint16 RSSI);
+
+    /**
+     * @return Whether there is a pathloss threshold. It is exclusive with the RSSI threshold.
+     */
+    bool hasPathloss() const;
+
+    /**
+     * @return The pathloss threshold in dB. Only devices with a lower pathloss are reported.
+     */
+    quint16 pathloss() const;
+
+    /**
+     * Sets the pathloss threshold, and removes the RSSI threshold.
+     */
+    void setPathloss(quint16 pathloss);
+
+    /**
+     * @return The services a device has to advertise, any of them, to be reported. Empty by
+     *         default, what means any device.
+     */
+    QStringList UUIDs() const;
+    void setUUIDs(const QStringList &UUIDs);
+
+    /**
+     * @return Whether every advertisement of a device is reported, even if its data did not
+     *         change. True by default, as BlueZ does.
+     */
+    bool duplicateData() const;
+    void setDuplicateData(bool duplicateData);
+
+    /**
+     * @return The filter in the form org.bluez.Adapter1.SetDiscoveryFilter takes it. Only the
+     *         criteria that differ from the defaults are included.
+     */
+    QVariantMap toVariantMap() const;
+
+private:
+    class Private;
+    QSharedDataPointer<Private> d;
+};
+
+}
+
+#endif // BLUEDEVILDISCOVERYFILTER_H
@@ -0,0 +1,464 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevilinfo.h"
+#include "bluedeviladapter.h"
+#include "bluedevildevice.h"
+
+#include <QtCore/QHash>
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ */
+class DeviceInfo::Private
+    : public QSharedData
+{
+public:
+    Private();
+
+    QString     m_UBI;
+    QString     m_adapterUBI;
+    QString     m_address;
+    QString     m_name;
+    QString     m_alias;
+    QString     m_friendlyName;
+    QString     m_icon;
+    quint32     m_deviceClass;
+    quint16     m_appearance;
+    quint32     m_type;
+    QString     m_modalias;
+    bool        m_paired;
+    bool        m_trusted;
+    bool        m_blocked;
+    bool        m_legacyPairing;
+    bool        m_connected;
+    QStringList m_UUIDs;
+    quint32     m_profiles;
+    qint16      m_RSSI;
+};
+
+DeviceInfo::Private::Private()
+    : m_deviceClass(0)
+    , m_appearance(0)
+    , m_type(0)
+    , m_paired(false)
+    , m_trusted(false)
+    , m_blocked(false)
+    , m_legacyPairing(false)
+    , m_connected(false)
+    , m_profiles(0)
+    , m_RSSI(0)
+{
+}
+
+/**
+ * @internal
+ */
+class AdapterInfo::Private
+    : public QSharedData
+{
+public:
+    Private();
+
+    QString           m_UBI;
+    QString           m_address;
+    QString           m_name;
+    QString           m_alias;
+    quint32           m_adapterClass;
+    bool              m_powered;
+    bool              m_discoverable;
+    bool              m_pairable;
+    quint32           m_pairableTimeout;
+    quint32           m_discoverableTimeout;
+    bool              m_discovering;
+    QStringList       m_UUIDs;
+    quint32           m_profiles;
+    QString           m_modalias;
+    QList<DeviceInfo> m_devices;
+};
+
+AdapterInfo::Private::Private()
+    : m_adapterClass(0)
+    , m_powered(false)
+    , m_discoverable(false)
+    , m_pairable(false)
+    , m_pairableTimeout(0)
+    , m_discoverableTimeout(0)
+    , m_discovering(false)
+    , m_profiles(0)
+{
+}
+
+/**
+ * @internal
+ */
+class ManagerInfo::Private
+    : public QSharedData
+{
+public:
+    Private();
+
+    quint64                     m_generation;
+    QList<AdapterInfo>          m_adapters;
+    int                         m_usableAdapter; // index in m_adapters, or -1
+    QHash<QString, DeviceInfo>  m_devices;
+};
+
+ManagerInfo::Private::Private()
+    : m_generation(0)
+    , m_usableAdapter(-1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeviceInfo::DeviceInfo()
+    : d(new Private)
+{
+}
+
+DeviceInfo::DeviceInfo(Device *device, const QString &adapterUBI)
+    : d(new Private)
+{
+    d->m_UBI = device->UBI();
+    d->m_adapterUBI = adapterUBI;
+    d->m_address = device->address();
+    d->m_name = device->name();
+    d->m_alias = device->alias();
+    d->m_friendlyName = device->friendlyName();
+    d->m_icon = device->icon();
+    d->m_deviceClass = device->deviceClass();
+    d->m_appearance = device->appearance();
+    d->m_type = device->type();
+    d->m_modalias = device->modalias();
+    d->m_paired = device->isPaired();
+    d->m_trusted = device->isTrusted();
+    d->m_blocked = device->isBlocked();
+    d->m_legacyPairing = device->hasLegacyPairing();
+    d->m_connected = device->isConnected();
+    d->m_UUIDs = device->UUIDs();
+    d->m_profiles = device->profiles();
+    d->m_RSSI = device->RSSI();
+}
+
+DeviceInfo::DeviceInfo(const DeviceInfo &other)
+    : d(other.d)
+{
+}
+
+DeviceInfo::~DeviceInfo()
+{
+}
+
+DeviceInfo &DeviceInfo::operator=(const DeviceInfo &other)
+{
+    d = other.d;
+    return *this;
+}
+
+bool DeviceInfo::isNull() const
+{
+    return d->m_UBI.isEmpty();
+}
+
+QString DeviceInfo::UBI() const
+{
+    return d->m_UBI;
+}
+
+QString DeviceInfo::adapterUBI() const
+{
+    return d->m_adapterUBI;
+}
+
+QString DeviceInfo::address() const
+{
+    return d->m_address;
+}
+
+QString DeviceInfo::name() const
+{
+    return d->m_name;
+}
+
+QString DeviceInfo::alias() const
+{
+    return d->m_alias;
+}
+
+QString DeviceInfo::friendlyName() const
+{
+    return d->m_friendlyName;
+}
+
+QString DeviceInfo::icon() const
+{
+    return d->m_icon;
+}
+
+quint32 DeviceInfo::deviceClass() const
+{
+    return d->m_deviceClass;
+}
+
+quint16 DeviceInfo::appearance() const
+{
+    return d->m_appearance;
+}
+
+quint32 DeviceInfo::type() const
+{
+    return d->m_type;
+}
+
+QString DeviceInfo::modalias() const
+{
+    return d->m_modalias;
+}
+
+bool DeviceInfo::isPaired() const
+{
+    return d->m_paired;
+}
+
+bool DeviceInfo::isTrusted() const
+{
+    return d->m_trusted;
+}
+
+bool DeviceInfo::isBlocked() const
+{
+    return d->m_blocked;
+}
+
+bool DeviceInfo::hasLegacyPairing() const
+{
+    return d->m_legacyPairing;
+}
+
+bool DeviceInfo::isConnected() const
+{
+    return d->m_connected;
+}
+
+QStringList DeviceInfo::UUIDs() const
+{
+    return d->m_UUIDs;
+}
+
+quint32 DeviceInfo::profiles() const
+{
+    return d->m_profiles;
+}
+
+qint16 DeviceInfo::RSSI() const
+{
+    return d->m_RSSI;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AdapterInfo::AdapterInfo()
+    : d(new Private)
+{
+}
+
+AdapterInfo::AdapterInfo(const QString &UBI, Adapter *adapter, const QList<DeviceInfo> &devices)
+    : d(new Private)
+{
+    d->m_UBI = UBI;
+    d->m_address = adapter->address();
+    d->m_name = adapter->name();
+    d->m_alias = adapter->alias();
+    d->m_adapterClass = adapter->adapterClass();
+    d->m_powered = adapter->isPowered();
+    d->m_discoverable = adapter->isDiscoverable();
+    d->m_pairable = adapter->isPairable();
+    d->m_pairableTimeout = adapter->paireableTimeout();
+    d->m_discoverableTimeout = adapter->discoverableTimeout();
+    d->m_discovering = adapter->isDiscovering();
+    d->m_UUIDs = adapter->UUIDs();
+    d->m_profiles = adapter->profiles();
+    d->m_modalias = adapter->modalias();
+    d->m_devices = devices;
+}
+
+AdapterInfo::AdapterInfo(const AdapterInfo &other)
+    : d(other.d)
+{
+}
+
+AdapterInfo::~AdapterInfo()
+{
+}
+
+AdapterInfo &AdapterInfo::operator=(const AdapterInfo &other)
+{
+    d = other.d;
+    return *this;
+}
+
+bool AdapterInfo::isNull() const
+{
+    return d->m_UBI.isEmpty();
+}
+
+QString AdapterInfo::UBI() const
+{
+    return d->m_UBI;
+}
+
+QString AdapterInfo::address() const
+{
+    return d->m_address;
+}
+
+QString AdapterInfo::name() const
+{
+    return d->m_name;
+}
+
+QString AdapterInfo::alias() const
+{
+    return d->m_alias;
+}
+
+quint32 AdapterInfo::adapterClass() const
+{
+    return d->m_adapterClass;
+}
+
+bool AdapterInfo::isPowered() const
+{
+    return d->m_powered;
+}
+
+bool AdapterInfo::isDiscoverable() const
+{
+    return d->m_discoverable;
+}
+
+bool AdapterInfo::isPairable() const
+{
+    return d->m_pairable;
+}
+
+quint32 AdapterInfo::paireableTimeout() const
+{
+    return d->m_pairableTimeout;
+}
+
+quint32 AdapterInfo::discoverableTimeout() const
+{
+    return d->m_discoverableTimeout;
+}
+
+bool AdapterInfo::isDiscovering() const
+{
+    return d->m_discovering;
+}
+
+QStringList AdapterInfo::UUIDs() const
+{
+    return d->m_UUIDs;
+}
+
+quint32 AdapterInfo::profiles() const
+{
+    return d->m_profiles;
+}
+
+QString AdapterInfo::modalias() const
+{
+    return d->m_modalias;
+}
+
+QList<DeviceInfo> AdapterInfo::devices() const
+{
+    return d->m_devices;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ManagerInfo::ManagerInfo()
+    : d(new Private)
+{
+}
+
+ManagerInfo::ManagerInfo(quint64 generation, const QList<AdapterInfo> &adapters, int usableAdapter)
+    : d(new Private)
+{
+    d->m_generation = generation;
+    d->m_adapters = adapters;
+    d->m_usableAdapter = usableAdapter;
+    Q_FOREACH (const AdapterInfo &adapter, adapters) {
+        Q_FOREACH (const DeviceInfo &device, adapter.devices()) {
+            d->m_devices.insert(device.UBI(), device);
+        }
+    }
+}
+
+ManagerInfo::ManagerInfo(const ManagerInfo &other)
+    : d(other.d)
+{
+}
+
+ManagerInfo::~ManagerInfo()
+{
+}
+
+ManagerInfo &ManagerInfo::operator=(const ManagerInfo &other)
+{
+    d = other.d;
+    return *this;
+}
+
+quint64 ManagerInfo::generation() const
+{
+    return d->m_generation;
+}
+
+bool ManagerInfo::isBluetoothOperational() const
+{
+    return d->m_usableAdapter != -1;
+}
+
+AdapterInfo ManagerInfo::usableAdapter() const
+{
+    return d->m_usableAdapter == -1 ? AdapterInfo() : d->m_adapters.at(d->m_usableAdapter);
+}
+
+QList<AdapterInfo> ManagerInfo::adapters() const
+{
+    return d->m_adapters;
+}
+
+QList<DeviceInfo> ManagerInfo::devices() const
+{
+    return d->m_devices.values();
+}
+
+DeviceInfo ManagerInfo::deviceForUBI(const QString &UBI) const
+{
+    return d->m_devices.value(UBI);
+}
+
+}
@@ -0,0 +1,217 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILINFO_H
+#define BLUEDEVILINFO_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QList>
+#include <QtCore/QSharedDataPointer>
+#include <QtCore/QStringList>
+
+namespace BlueDevil {
+
+class Adapter;
+class Device;
+
+/**
+ * @class DeviceInfo bluedevilinfo.h bluedevil/bluedevilinfo.h
+ *
+ * The state of a Device at some point in time. It never changes once created, and it is
+ * implicitly shared, so it can be copied around and read from any thread.
+ *
+ * @see Manager::info
+ */
+class BLUEDEVIL_EXPORT DeviceInfo
+{
+    friend class ManagerPrivate;
+
+public:
+    /**
+     * Creates a null info.
+     */
+    DeviceInfo();
+    DeviceInfo(const DeviceInfo &other);
+    ~DeviceInfo();
+
+    DeviceInfo &operator=(const DeviceInfo &other);
+
+    /**
+     * @return Whether this info does not describe any device.
+     */
+    bool isNull() const;
+
+    /**
+     * See Device::UBI and the other getters of Device.
+     */
+    QString UBI() const;
+    QString adapterUBI() const;
+    QString address() const;
+    QString name() const;
+    QString alias() const;
+    QString friendlyName() const;
+    QString icon() const;
+    quint32 deviceClass() const;
+    quint16 appearance() const;
+    quint32 type() const;
+    QString modalias() const;
+    bool isPaired() const;
+    bool isTrusted() const;
+    bool isBlocked() const;
+    bool hasLegacyPairing() const;
+    bool isConnected() const;
+    QStringList UUIDs() const;
+    quint32 profiles() const;
+    qint16 RSSI() const;
+
+private:
+    /**
+     * @internal
+     */
+    DeviceInfo(Device *device, const QString &adapterUBI);
+
+    class Private;
+    QSharedDataPointer<Private> d;
+};
+
+/**
+ * @class AdapterInfo bluedevilinfo.h bluedevil/bluedevilinfo.h
+ *
+ * The state of an Adapter and of its devices at some point in time. Like DeviceInfo, it never
+ * changes and can be read from any thread.
+ *
+ * @see Manager::info
+ */
+class BLUEDEVIL_EXPORT AdapterInfo
+{
+    friend class ManagerPrivate;
+
+public:
+    /**
+     * Creates a null info.
+     */
+    AdapterInfo();
+    AdapterInfo(const AdapterInfo &other);
+    ~AdapterInfo();
+
+    AdapterInfo &operator=(const AdapterInfo &other);
+
+    /**
+     * @return Whether this info does not describe any adapter.
+     */
+    bool isNull() const;
+
+    /**
+     * See Adapter::UBI and the other getters of Adapter.
+     */
+    QString UBI() const;
+    QString address() const;
+    QString name() const;
+    QString alias() const;
+    quint32 adapterClass() const;
+    bool isPowered() const;
+    bool isDiscoverable() const;
+    bool isPairable() const;
+    quint32 paireableTimeout() const;
+    quint32 discoverableTimeout() const;
+    bool isDiscovering() const;
+    QStringList UUIDs() const;
+    quint32 profiles() const;
+    QString modalias() const;
+
+    /**
+     * @return The devices of the adapter.
+     */
+    QList<DeviceInfo> devices() const;
+
+private:
+    /**
+     * @internal
+     */
+    AdapterInfo(const QString &UBI, Adapter *adapter, const QList<DeviceInfo> &devices);
+
+    class Private;
+    QSharedDataPointer<Private> d;
+};
+
+/**
+ * @class ManagerInfo bluedevilinfo.h bluedevil/bluedevilinfo.h
+ *
+ * A consistent view of all the adapters and devices, as returned by Manager::info. It never
+ * changes and can be read from any thread.
+ */
+class BLUEDEVIL_EXPORT ManagerInfo
+{
+    friend class ManagerPrivate;
+
+public:
+    /**
+     * Creates an info with no adapters.
+     */
+    ManagerInfo();
+    ManagerInfo(const ManagerInfo &other);
+    ~ManagerInfo();
+
+    ManagerInfo &operator=(const ManagerInfo &other);
+
+    /**
+     * @return A number that grows each time a new info is published. Two infos with the same
+     *         generation describe the same state.
+     */
+    quint64 generation() const;
+
+    /**
+     * See Manager::isBluetoothOperational.
+     */
+    bool isBluetoothOperational() const;
+
+    /**
+     * @return The usable adapter, or a null info if there is none. See Manager::usableAdapter.
+     */
+    AdapterInfo usableAdapter() const;
+
+    QList<AdapterInfo> adapters() const;
+
+    /**
+     * @return The devices of all the adapters.
+     */
+    QList<DeviceInfo> devices() const;
+
+    /**
+     * @return The device with the given UBI, or a null info if there is none. It is a single hash
+     *         lookup.
+     */
+    DeviceInfo deviceForUBI(const QString &UBI) const;
+
+private:
+    /**
+     * @internal
+     *
+     * @p usableAdapter is an index in @p adapters, or -1.
+     */
+    ManagerInfo(quint64 generation, const QList<AdapterInfo> &adapters, int usableAdapter);
+
+    class Private;
+    QSharedDataPointer<Private> d;
+};
+
+}
+
+#endif // BLUEDEVILINFO_H
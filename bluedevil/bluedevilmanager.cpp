@@ -24,21 +24,38 @@
 #include "bluedeviladapter.h"
 #include "bluedevildevice.h"
 #include "bluedevilmanager_p.h"
+#include "bluedevilpendingcall.h"
+#include "bluedevilstatistics_p.h"
 #include "bluedevildbustypes.h"
 
 #include "bluedevil/dbusobjectmanager.h"
 #include "bluedevil/bluezagentmanager1.h"
 
 #include <QtCore/QHash>
+#include <QtCore/QMap>
 #include <QVariantMap>
 
 #include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusPendingCall>
 
 namespace BlueDevil {
 
 static Manager *instance = 0;
+static Manager::InitializationMode initializationMode = Manager::BlockingInitialization;
+static QString snapshotPath;
+static bool dbusThreadEnabled = false;
 
-void Manager::registerAgent(const QString &agentPath, RegisterCapability registerCapability)
+DeviceVisitor::~DeviceVisitor()
+{
+}
+
+static QDBusPendingCall bluezNotRunningCall()
+{
+    return QDBusPendingCall::fromError(QDBusError(QDBusError::ServiceUnknown, "BlueZ is not running"));
+}
+
+PendingCall *Manager::registerAgent(const QString &agentPath, RegisterCapability registerCapability)
 {
     QString capability;
 
@@ -56,22 +73,34 @@ void Manager::registerAgent(const QString &agentPath, RegisterCapability registe
             capability = "NoInputNoOutput";
             break;
         default:
-            return;
+            return new PendingCall(QDBusPendingCall::fromError(QDBusError(QDBusError::InvalidArgs, "Invalid agent capability")), this);
+    }
+
+    if (!d->m_bluezAgentManager) {
+        return new PendingCall(bluezNotRunningCall(), this);
     }
 
     QDBusObjectPath agentObjectPath = QDBusObjectPath(agentPath);
-    d->m_bluezAgentManager->RegisterAgent(agentObjectPath, capability);
+    return new PendingCall(d->m_bluezAgentManager->RegisterAgent(agentObjectPath, capability), "org.bluez.AgentManager1", "RegisterAgent", this);
 }
 
-void Manager::requestDefaultAgent(const QString& agentPath)
+PendingCall *Manager::requestDefaultAgent(const QString& agentPath)
 {
+    if (!d->m_bluezAgentManager) {
+        return new PendingCall(bluezNotRunningCall(), this);
+    }
+
     QDBusObjectPath agentObjectPath = QDBusObjectPath(agentPath);
-    d->m_bluezAgentManager->RequestDefaultAgent(agentObjectPath);
+    return new PendingCall(d->m_bluezAgentManager->RequestDefaultAgent(agentObjectPath), "org.bluez.AgentManager1", "RequestDefaultAgent", this);
 }
 
-void Manager::unregisterAgent(const QString &agentPath)
+PendingCall *Manager::unregisterAgent(const QString &agentPath)
 {
-    d->m_bluezAgentManager->UnregisterAgent(QDBusObjectPath(agentPath));
+    if (!d->m_bluezAgentManager) {
+        return new PendingCall(bluezNotRunningCall(), this);
+    }
+
+    return new PendingCall(d->m_bluezAgentManager->UnregisterAgent(QDBusObjectPath(agentPath)), "org.bluez.AgentManager1", "UnregisterAgent", this);
 }
 
 
@@ -89,7 +118,15 @@ Manager::Manager(QObject *parent)
     connect(serviceWatcher, SIGNAL(serviceRegistered(QString)), d, SLOT(_k_bluezServiceRegistered()));
     connect(serviceWatcher, SIGNAL(serviceUnregistered(QString)), d, SLOT(_k_bluezServiceUnregistered()));
 
-    d->initialize();
+    // Keep the info published for other threads up to date
+    connect(this, SIGNAL(adapterAdded(Adapter*)), d, SLOT(_k_adapterAdded(Adapter*)));
+    connect(this, SIGNAL(adapterRemoved(Adapter*)), d, SLOT(_k_adapterRemoved(Adapter*)));
+    connect(this, SIGNAL(usableAdapterChanged(Adapter*)), d, SLOT(_k_infoChanged()));
+
+    d->m_initializationMode = initializationMode;
+    d->m_snapshotPath = snapshotPath;
+    d->m_useSignalThread = dbusThreadEnabled;
+    d->start();
 }
 
 Manager::~Manager()
@@ -111,9 +148,84 @@ void Manager::release()
     instance = 0;
 }
 
+void Manager::setInitializationMode(InitializationMode mode)
+{
+    initializationMode = mode;
+}
+
+void Manager::setSnapshotPath(const QString &path)
+{
+    snapshotPath = path;
+}
+
+QString Manager::snapshotPath()
+{
+    return BlueDevil::snapshotPath;
+}
+
+void Manager::setDBusThreadEnabled(bool enabled)
+{
+    dbusThreadEnabled = enabled;
+}
+
+bool Manager::isDBusThreadEnabled()
+{
+    return dbusThreadEnabled;
+}
+
+bool Manager::isProvisional() const
+{
+    return d->m_provisional;
+}
+
+bool Manager::saveSnapshot() const
+{
+    return d->saveSnapshot();
+}
+
+bool Manager::startRecording(const QString &fileName)
+{
+    return d->startRecording(fileName);
+}
+
+void Manager::stopRecording()
+{
+    d->stopRecording();
+}
+
+bool Manager::isRecording() const
+{
+    return d->m_traceWriter != 0;
+}
+
+bool Manager::isReplaying() const
+{
+    return d->m_replaying;
+}
+
+ManagerInfo Manager::info()
+{
+    return ManagerPrivate::publishedInfo();
+}
+
+BusStatistics Manager::busStatistics()
+{
+    return BlueDevil::busStatistics();
+}
+
+void Manager::resetBusStatistics()
+{
+    BlueDevil::resetBusStatistics();
+}
+
+bool Manager::isInitialized() const
+{
+    return d->m_initialized;
+}
+
 Adapter *Manager::usableAdapter() const
 {
-    if (!QDBusConnection::systemBus().isConnected() || !d->m_bluezServiceRunning) {
+    if (!d->m_replaying && (!QDBusConnection::systemBus().isConnected() || (!d->m_bluezServiceRunning && !d->m_provisional))) {
         return 0;
     }
 
@@ -125,7 +237,7 @@ Adapter *Manager::usableAdapter() const
 
 QList<Adapter*> Manager::adapters() const
 {
-    if (!QDBusConnection::systemBus().isConnected() || !d->m_bluezServiceRunning) {
+    if (!d->m_replaying && (!QDBusConnection::systemBus().isConnected() || (!d->m_bluezServiceRunning && !d->m_provisional))) {
         return QList<Adapter*>();
     }
 
@@ -134,30 +246,49 @@ QList<Adapter*> Manager::adapters() const
 
 Device* Manager::deviceForUBI(const QString& UBI) const
 {
-    Device *device = 0;
-    Q_FOREACH(Adapter *adapter, d->m_adapters) {
-        device = adapter->deviceForUBI(UBI);
-        if (device) {
-            return device;
-        }
-    }
-
-    return 0;
+    return d->deviceForUBI(UBI);
 }
 
 QList<Device*> Manager::devices() const
 {
+    // By the path of their adapter, and then by address, as each adapter lists them
     QList<Device*> devices;
-    Q_FOREACH(Adapter *adapter, d->m_adapters) {
-        devices << adapter->devices();
+    Q_FOREACH (Adapter *const adapter, d->m_adapters) {
+        devices += adapter->devices();
     }
 
+    // Devices of an adapter that is already gone come last
+    if (devices.count() != d->m_devices.count()) {
+        QMap<quint64, Device*> orphans;
+        Q_FOREACH (Device *const device, d->m_devices) {
+            Adapter *const adapter = device->adapter();
+            if (d->m_adapters.value(adapter->objectPath()) != adapter) {
+                orphans.insertMulti(device->addressKey(), device);
+            }
+        }
+        devices += orphans.values();
+    }
     return devices;
 }
 
+int Manager::deviceCount() const
+{
+    return d->m_devices.count();
+}
+
+void Manager::visitDevices(DeviceVisitor *visitor) const
+{
+    QHash<QString, Device*>::const_iterator it;
+    for (it = d->m_devices.constBegin(); it != d->m_devices.constEnd(); ++it) {
+        if (!visitor->visit(it.value())) {
+            return;
+        }
+    }
+}
+
 bool Manager::isBluetoothOperational() const
 {
-    return QDBusConnection::systemBus().isConnected() && d->m_bluezServiceRunning && usableAdapter();
+    return usableAdapter() != 0;
 }
 
 }
@@ -24,6 +24,8 @@
 #define BLUEDEVILMANAGER_H
 
 #include <bluedevil/bluedevil_export.h>
+#include <bluedevil/bluedevilinfo.h>
+#include <bluedevil/bluedevilstatistics.h>
 
 #include <QtCore/QObject>
 #include <QtDBus/QDBusObjectPath>
@@ -33,6 +35,26 @@ namespace BlueDevil {
 class Device;
 class Adapter;
 class ManagerPrivate;
+class PendingCall;
+
+/**
+ * @class DeviceVisitor bluedevilmanager.h bluedevil/bluedevilmanager.h
+ *
+ * Callback for Manager::visitDevices. Reimplement visit() with whatever has to be done for each
+ * device.
+ */
+class BLUEDEVIL_EXPORT DeviceVisitor
+{
+public:
+    virtual ~DeviceVisitor();
+
+    /**
+     * Called once for each device.
+     *
+     * @return Whether to keep visiting the remaining devices.
+     */
+    virtual bool visit(Device *device) = 0;
+};
 
 /**
  * @class Manager bluedevilmanager.h bluedevil/bluedevilmanager.h
@@ -58,6 +80,7 @@ class BLUEDEVIL_EXPORT Manager
     Q_PROPERTY(bool isBluetoothOperational READ isBluetoothOperational)
 
     friend class ManagerPrivate;
+    friend class TraceReplayer;
 public:
     enum RegisterCapability {
         DisplayOnly = 0,
@@ -66,6 +89,11 @@ public:
         NoInputNoOutput = 3
     };
 
+    enum InitializationMode {
+        BlockingInitialization = 0,
+        NonBlockingInitialization = 1
+    };
+
     virtual ~Manager();
 
     /**
@@ -80,6 +108,142 @@ public:
      */
     static void release();
 
+    /**
+     * Sets how the Manager instance is going to be initialized. It has to be called before the
+     * first call to self(), otherwise it has no effect.
+     *
+     * With BlockingInitialization (the default) self() will not return until all adapters and
+     * devices have been retrieved from BlueZ.
+     *
+     * With NonBlockingInitialization self() returns immediately, and the adapters and devices are
+     * retrieved in the background. adapterAdded and usableAdapterChanged signals will be emitted
+     * as they become available, and initialized will be emitted when the process has finished.
+     */
+    static void setInitializationMode(InitializationMode mode);
+
+    /**
+     * Sets the file where the Manager keeps a snapshot of the adapters and of the paired or
+     * trusted devices, with their properties. It has to be called before the first call to
+     * self(), otherwise it has no effect. No snapshot is kept by default.
+     *
+     * If the file holds a snapshot, self() presents it right away as provisional state, without
+     * waiting for BlueZ, whatever the initialization mode. The snapshot is then reconciled with
+     * BlueZ in the background: only the differences are signalled, as property changes and
+     * devices or adapters being added or removed, and initialized is emitted once done.
+     *
+     * The snapshot is written again after each reconciliation, and when the Manager is released.
+     */
+    static void setSnapshotPath(const QString &path);
+
+    /**
+     * @return The file set through setSnapshotPath.
+     */
+    static QString snapshotPath();
+
+    /**
+     * Sets whether the Manager listens to BlueZ from a thread of its own. It has to be called
+     * before the first call to self(), otherwise it has no effect. It is disabled by default.
+     *
+     * When enabled, the signals from BlueZ are received and demarshalled on a separate connection
+     * to the system bus, owned by a background thread. Only the decoded changes reach the thread
+     * of the Manager, in batches, with consecutive property changes of the same object merged.
+     * This keeps a busy bus, like one with many devices being discovered, from stalling the
+     * event loop of the application. Adapters, devices and their signals still live in the thread
+     * of the Manager, and method calls are still made from it.
+     *
+     * If the background connection cannot be established the Manager falls back to listening
+     * from its own thread.
+     */
+    static void setDBusThreadEnabled(bool enabled);
+
+    /**
+     * @return Whether setDBusThreadEnabled was last called with true.
+     */
+    static bool isDBusThreadEnabled();
+
+    /**
+     * @return Whether the adapters and devices still come from the snapshot, and have not been
+     *         reconciled with BlueZ yet.
+     */
+    bool isProvisional() const;
+
+    /**
+     * Writes the snapshot now, so that recent pairings are kept even if the application does not
+     * release the Manager.
+     *
+     * @return Whether the snapshot was written. It is not while the state is provisional or BlueZ
+     *         is not running.
+     */
+    bool saveSnapshot() const;
+
+    /**
+     * Starts writing to @p fileName the signals received from BlueZ about adapters and devices
+     * being added, removed or changed, with the time at which they arrived. The trace begins with
+     * the adapters and devices already known. It can be fed back later through a TraceReplayer,
+     * without BlueZ, to reproduce the behaviour of the library.
+     *
+     * Property values that are not basic types are not recorded. A recording already in progress
+     * is stopped first.
+     *
+     * @return Whether @p fileName could be opened.
+     */
+    bool startRecording(const QString &fileName);
+
+    /**
+     * Stops the recording started with startRecording, and closes the trace file.
+     */
+    void stopRecording();
+
+    /**
+     * @return Whether signals from BlueZ are being recorded.
+     */
+    bool isRecording() const;
+
+    /**
+     * @return Whether the adapters and devices come from a TraceReplayer. The Manager does not
+     *         listen to BlueZ anymore once a replay has started, until it is released.
+     */
+    bool isReplaying() const;
+
+    /**
+     * @return The adapters and devices as they were when the thread of the Manager last processed
+     *         events. Unlike the rest of the library, this can be called from any thread, without
+     *         blocking for longer than copying a pointer and without going to the bus.
+     *
+     * A new info is built when it is read after adapters or devices were added, removed or
+     * changed: right away in the thread of the Manager, and otherwise the next time that thread
+     * processes events, the previous info being returned meanwhile. The info of the adapters and
+     * devices that did not change is shared with the previous one. Compare
+     * ManagerInfo::generation to tell whether anything changed.
+     *
+     * @note Nothing is published until self() has been called, and an empty info is published
+     *       when the Manager is released.
+     */
+    static ManagerInfo info();
+
+    /**
+     * @return How many calls BlueDevil made to BlueZ, per interface and property or method, and
+     *         how long they took, along with the signals received from it. Property getters of
+     *         Adapter and Device are answered from a cache and do not show up here, their setters
+     *         do.
+     *
+     * The statistics are kept for the whole process, even across release(). Keeping them costs a
+     * hash lookup per call and a counter increment per signal, so they are always on.
+     */
+    static BusStatistics busStatistics();
+
+    /**
+     * Clears the statistics returned by busStatistics. Calls still waiting for a reply are still
+     * counted as in flight.
+     */
+    static void resetBusStatistics();
+
+    /**
+     * @return Whether the initial list of adapters and devices has already been retrieved. It is
+     *         always true when the Manager was initialized with BlockingInitialization.
+     */
+    bool isInitialized() const;
+
     /**
      * @return The first adapter that is ready to be used (is powered). If there are no usable
      *         adapters, NULL will be returned.
@@ -94,9 +258,8 @@ public:
     /**
      * Returns a device for a given UBI independently of the adapter they are in
      *
-     * All devices belong to an adapter so in order to find a device when we have more than
-     * one adapter is iterating on all adapters and call deviceForUBI. This method basically
-     * does that so application developers doesn't have to do it.
+     * The Manager keeps an index of the devices of all adapters by UBI, so this is a single
+     * hash lookup.
      *
      * @param Device UBI to find
      * @return A device for the given UBI or null if none is found
@@ -105,9 +268,26 @@ public:
 
     /**
      * Return a list of all known devices by all connected adaptors
-     * @return a list of all known devices
+     * @return a list of all known devices, grouped by adapter and sorted by address
+     *
+     * @note The list is built on each call. Use visitDevices to go through all the devices without
+     *       allocating, or deviceCount if you only need to know how many there are.
      */
     QList<Device*> devices() const;
+
+    /**
+     * @return The number of known devices by all connected adapters.
+     */
+    int deviceCount() const;
+
+    /**
+     * Calls @p visitor for each known device, until all of them have been visited or the visitor
+     * returns false.
+     *
+     * @note Devices are not added or removed while visiting, as long as the visitor does not
+     *       process events.
+     */
+    void visitDevices(DeviceVisitor *visitor) const;
     /**
      * @return Whether the bluetooth system is ready to be used, and there is a usable adapter
      *         connected and turned on at the system.
@@ -117,24 +297,33 @@ public:
      *
      * @note If this method returns false, you can connect to the usableAdapterChanged signal, so
      *       you can be notified when bluetooth is operational.
+     *
+     * @note While the state is provisional, this reports what the snapshot says.
      */
     bool isBluetoothOperational() const;
 
 public Q_SLOTS:
     /**
      * Registers agent.
+     *
+     * @return A pending call that will report whether the agent was registered. It fails right
+     *         away if BlueZ is not running or @p registerCapability is not valid.
      */
-    void registerAgent(const QString &agentPath, RegisterCapability registerCapability);
+    PendingCall *registerAgent(const QString &agentPath, RegisterCapability registerCapability);
 
     /**
      * Unregisters agent.
+     *
+     * @return A pending call that will report whether the agent was unregistered.
      */
-    void unregisterAgent(const QString &agentPath);
+    PendingCall *unregisterAgent(const QString &agentPath);
 
     /**
      * Request to set Agent with agentPath as default agent.
+     *
+     * @return A pending call that will report whether the agent is now the default one.
      */
-    void requestDefaultAgent(const QString &agentPath);
+    PendingCall *requestDefaultAgent(const QString &agentPath);
 
 Q_SIGNALS:
     /**
@@ -167,6 +356,13 @@ Q_SIGNALS:
      */
     void allAdaptersRemoved();
 
+    /**
+     * This signal will be emitted when the initial list of adapters and devices has been
+     * retrieved. It is only useful with NonBlockingInitialization, since otherwise it is emitted
+     * before self() returns.
+     */
+    void initialized();
+
 private:
     /**
      * @internal
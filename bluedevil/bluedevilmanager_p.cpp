@@ -19,88 +19,293 @@
 #include "bluedevilmanager.h"
 #include "bluedevilmanager_p.h"
 #include "bluedeviladapter.h"
+#include "bluedevildevice.h"
+#include "bluedevilsignalthread_p.h"
+#include "bluedevilsnapshot_p.h"
+#include "bluedevilstatistics_p.h"
+#include "bluedeviltrace_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
 
 namespace BlueDevil {
 
+/**
+ * @internal
+ *
+ * The last ManagerInfo published, for any thread to read. The lock is only held to copy a pointer.
+ */
+struct PublishedInfo
+{
+    PublishedInfo()
+        : builder(0)
+        , buildQueued(false)
+    {
+    }
+
+    QMutex          mutex;
+    ManagerInfo     info;
+    ManagerPrivate *builder;     // set while info is out of date
+    bool            buildQueued; // in the thread of the builder, for a reader in another thread
+};
+
+Q_GLOBAL_STATIC(PublishedInfo, publishedInfoInstance)
+
+// Only written from the thread of the Manager
+static quint64 infoGeneration = 0;
+
 ManagerPrivate::ManagerPrivate(Manager *q)
     : QObject(q)
     , m_dbusObjectManager(0)
     , m_bluezAgentManager(0)
     , m_usableAdapter(0)
+    , m_bluezServiceRunning(false)
+    , m_initializationMode(Manager::BlockingInitialization)
+    , m_initialized(false)
+    , m_managedObjectsWatcher(0)
+    , m_provisional(false)
+    , m_traceWriter(0)
+    , m_replaying(false)
+    , m_infoStale(false)
+    , m_traceFlushQueued(false)
+    , m_useSignalThread(false)
+    , m_signalThread(0)
     , m_q(q)
 {
     qDBusRegisterMetaType<DBusManagerStruct>();
     qDBusRegisterMetaType<QVariantMapMap>();
-
-    m_bluezServiceRunning = false;
-    if (QDBusConnection::systemBus().isConnected()) {
-        QDBusReply<bool> reply = QDBusConnection::systemBus().interface()->isServiceRegistered("org.bluez");
-
-        if (reply.isValid()) {
-            m_bluezServiceRunning = reply.value();
-        }
-    }
+    qRegisterMetaType<BlueDevil::QUInt32StringMap>("BlueDevil::QUInt32StringMap");
+    qDBusRegisterMetaType<BlueDevil::QUInt32StringMap>();
 }
 
 ManagerPrivate::~ManagerPrivate()
 {
+    stopSignalThread();
+    saveSnapshot();
+    stopRecording();
+    abandonManagedObjectsCall();
+    publishInfo(ManagerInfo(++infoGeneration, QList<AdapterInfo>(), -1));
     delete m_dbusObjectManager;
     delete m_bluezAgentManager;
 }
 
+void ManagerPrivate::start()
+{
+    if (!QDBusConnection::systemBus().isConnected()) {
+        setInitialized();
+        return;
+    }
+
+    if (loadSnapshot()) {
+        // The snapshot stands in for BlueZ until it has been reconciled in the background
+        m_initializationMode = Manager::NonBlockingInitialization;
+    }
+
+    if (m_initializationMode == Manager::NonBlockingInitialization) {
+        QDBusPendingCall call = QDBusConnection::systemBus().interface()->asyncCall("NameHasOwner", QString("org.bluez"));
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        watcher->setProperty("started", statisticsClock());
+        asyncCallStarted();
+        connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)), SLOT(_k_bluezServiceChecked(QDBusPendingCallWatcher*)));
+        return;
+    }
+
+    {
+        SynchronousCall call("org.freedesktop.DBus", "NameHasOwner", CallStatistics::MethodCall);
+        QDBusReply<bool> reply = QDBusConnection::systemBus().interface()->isServiceRegistered("org.bluez");
+        call.setFailed(!reply.isValid());
+        if (reply.isValid()) {
+            m_bluezServiceRunning = reply.value();
+        }
+    }
+    initialize();
+}
+
 void ManagerPrivate::initialize()
 {
-    if (QDBusConnection::systemBus().isConnected() && m_bluezServiceRunning) {
-        m_dbusObjectManager = new org::freedesktop::DBus::ObjectManager("org.bluez", "/", QDBusConnection::systemBus(), m_q);
+    if (m_replaying) {
+        return;
+    }
+
+    if (!QDBusConnection::systemBus().isConnected() || !m_bluezServiceRunning) {
+        if (m_provisional) {
+            // Nothing in the snapshot is there without BlueZ
+            clean();
+        }
+        setInitialized();
+        return;
+    }
+
+    if (m_dbusObjectManager) {
+        // Already initialized or initializing
+        return;
+    }
 
+    m_dbusObjectManager = new org::freedesktop::DBus::ObjectManager("org.bluez", "/", QDBusConnection::systemBus(), m_q);
+
+    // The thread listens before GetManagedObjects is sent, so nothing is missed in between
+    if (!m_useSignalThread || !startSignalThread()) {
         connect(m_dbusObjectManager, SIGNAL(InterfacesAdded(QDBusObjectPath,QVariantMapMap)),
                 SLOT(_k_interfacesAdded(QDBusObjectPath,QVariantMapMap)));
         connect(m_dbusObjectManager, SIGNAL(InterfacesRemoved(QDBusObjectPath,QStringList)),
                 SLOT(_k_interfacesRemoved(QDBusObjectPath,QStringList)));
 
-        QDBusPendingReply<DBusManagerStruct> reply = m_dbusObjectManager->GetManagedObjects();
-        reply.waitForFinished();
-        if (!reply.isError()) {
-            QHash<QString,QString> devices;
-            DBusManagerStruct managedObjects = reply.value();
-            DBusManagerStruct::const_iterator managedObjectIt;
-            for(managedObjectIt = managedObjects.constBegin(); managedObjectIt != managedObjects.constEnd(); ++managedObjectIt) {
-                QString path = managedObjectIt.key().path();
-                QVariantMapMap interfaces = managedObjectIt.value();
-                if(interfaces.contains("org.bluez.Adapter1")) {
-                    Adapter *const adapter = new Adapter(path, m_q);
-                    connect(adapter, SIGNAL(poweredChanged(bool)), SLOT(_k_bluezAdapterPoweredChanged(bool)));
-                    m_adapters.insert(managedObjectIt.key().path(), adapter);
-                } else if(interfaces.contains("org.bluez.Device1")) {
-                    QString adapterPath = managedObjectIt.value().value("org.bluez.Device1").value("Adapter").value<QDBusObjectPath>().path();
-                    devices.insert(path,adapterPath);
-                } else if(interfaces.contains("org.bluez.AgentManager1")) {
+        // A single match rule for the properties of every object exported by BlueZ, instead of one
+        // per Adapter and Device. The signals are routed by object path in _k_propertiesChanged.
+        QDBusConnection::systemBus().connect("org.bluez", QString(), "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                             this, SLOT(_k_propertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
+    }
+
+    const qint64 started = statisticsClock();
+    QDBusPendingReply<DBusManagerStruct> reply = m_dbusObjectManager->GetManagedObjects();
+    if (m_initializationMode == Manager::NonBlockingInitialization) {
+        m_managedObjectsWatcher = new QDBusPendingCallWatcher(reply, this);
+        m_managedObjectsWatcher->setProperty("started", started);
+        asyncCallStarted();
+        connect(m_managedObjectsWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                SLOT(_k_managedObjectsReceived(QDBusPendingCallWatcher*)));
+        return;
+    }
+
+    reply.waitForFinished();
+    recordCall("org.freedesktop.DBus.ObjectManager", QLatin1String("GetManagedObjects"), CallStatistics::MethodCall, true,
+               started, reply.isError());
+    loadManagedObjects(reply);
+}
+
+void ManagerPrivate::loadManagedObjects(const QDBusPendingReply<DBusManagerStruct> &reply)
+{
+    QList<Adapter*> addedAdapters;
+    QSet<QString> livePaths;
+    const bool provisional = m_provisional;
+    Adapter *const oldUsableAdapter = m_usableAdapter;
+    if (!reply.isError()) {
+        QHash<QString,QVariantMap> devices;
+        DBusManagerStruct managedObjects = reply.value();
+        DBusManagerStruct::const_iterator managedObjectIt;
+        for(managedObjectIt = managedObjects.constBegin(); managedObjectIt != managedObjects.constEnd(); ++managedObjectIt) {
+            QString path = managedObjectIt.key().path();
+            QVariantMapMap interfaces = managedObjectIt.value();
+            if(interfaces.contains("org.bluez.Adapter1")) {
+                livePaths.insert(path);
+                // It could come from the snapshot, or have been already announced by
+                // InterfacesAdded while we were waiting
+                if (Adapter *const adapter = m_adapters.value(path)) {
+                    reconcileProperties(adapter, interfaces.value("org.bluez.Adapter1"));
+                    continue;
+                }
+                Adapter *const adapter = new Adapter(path, interfaces.value("org.bluez.Adapter1"), m_q);
+                connect(adapter, SIGNAL(poweredChanged(bool)), SLOT(_k_bluezAdapterPoweredChanged(bool)));
+                m_adapters.insert(path, adapter);
+                addedAdapters << adapter;
+            } else if(interfaces.contains("org.bluez.Device1")) {
+                livePaths.insert(path);
+                devices.insert(path, interfaces.value("org.bluez.Device1"));
+            } else if(interfaces.contains("org.bluez.AgentManager1")) {
+                if (!m_bluezAgentManager) {
                     m_bluezAgentManager = new org::bluez::AgentManager1("org.bluez",path,QDBusConnection::systemBus(), m_q);
                 }
             }
+        }
+
+        QHash<QString,QVariantMap>::const_iterator deviceIt;
+        for(deviceIt = devices.constBegin(); deviceIt != devices.constEnd(); ++deviceIt) {
+            QString devicePath = deviceIt.key();
+            QString adapterPath = deviceIt.value().value("Adapter").value<QDBusObjectPath>().path();
 
-            QHash<QString,QString>::const_iterator deviceIt;
-            for(deviceIt = devices.constBegin(); deviceIt != devices.constEnd(); ++deviceIt) {
-                QString devicePath = deviceIt.key();
-                QString adapterPath = deviceIt.value();
+            Adapter * const adapter = m_adapters.value(adapterPath);
+            if (!adapter) {
+                continue;
+            }
+            if (Device *const device = m_devices.value(devicePath)) {
+                reconcileProperties(device, deviceIt.value());
+                continue;
+            }
+            Device *const device = adapter->addDevice(devicePath, deviceIt.value());
+            m_devices.insert(devicePath, device);
+            adapter->announceDevice(device);
+        }
+    } else {
+        //TODO: error handling
+    }
 
-                Adapter * const adapter = m_adapters.value(adapterPath);
-                adapter->addDevice(devicePath);
-                m_devAdapter.insert(devicePath,adapter);
+    if (provisional) {
+        // Whatever the snapshot had and BlueZ does not know about is gone
+        m_provisional = false;
+        Q_FOREACH (const QString &path, m_devices.keys()) {
+            if (!livePaths.contains(path)) {
+                interfacesRemoved(QDBusObjectPath(path), QStringList() << "org.bluez.Device1");
             }
-        } else {
-            //TODO: error handling
         }
-        m_usableAdapter = findUsableAdapter();
+        Q_FOREACH (const QString &path, m_adapters.keys()) {
+            if (!livePaths.contains(path)) {
+                interfacesRemoved(QDBusObjectPath(path), QStringList() << "org.bluez.Adapter1");
+            }
+        }
+
+        // The removals above are not signals, so they are not traced. A trace started from the
+        // snapshot starts over from what BlueZ has instead of keeping the objects that are gone.
+        if (m_traceWriter) {
+            startRecording(m_traceWriter->fileName());
+        }
+    }
+
+    Q_FOREACH (Adapter *const adapter, addedAdapters) {
+        emit m_q->adapterAdded(adapter);
+    }
+
+    m_usableAdapter = findUsableAdapter();
+    if (!provisional || m_usableAdapter != oldUsableAdapter) {
         emit m_q->usableAdapterChanged(m_usableAdapter);
     }
+
+    // Whatever the signal thread saw in the meantime happened after the reply was built
+    const QList<TraceEvent> heldEvents = m_heldSignalEvents;
+    m_heldSignalEvents.clear();
+    applySignalEvents(heldEvents);
+
+    setInitialized();
+    saveSnapshot();
+}
+
+void ManagerPrivate::abandonManagedObjectsCall()
+{
+    if (!m_managedObjectsWatcher) {
+        return;
+    }
+
+    // It will not be answered as far as the statistics are concerned
+    recordCall("org.freedesktop.DBus.ObjectManager", QLatin1String("GetManagedObjects"), CallStatistics::MethodCall, false,
+               m_managedObjectsWatcher->property("started").toLongLong(), true);
+    delete m_managedObjectsWatcher;
+    m_managedObjectsWatcher = 0;
+}
+
+void ManagerPrivate::setInitialized()
+{
+    if (m_initialized) {
+        return;
+    }
+    m_initialized = true;
+    // Other threads can see the adapters and devices as soon as self() returns
+    invalidateInfo();
+    _k_publishInfo();
+    emit m_q->initialized();
 }
 
 void ManagerPrivate::clean()
 {
     qDebug() << "Private::clean";
+    stopSignalThread();
+    abandonManagedObjectsCall();
     delete m_dbusObjectManager;
+    m_dbusObjectManager = 0;
     delete m_bluezAgentManager;
+    m_bluezAgentManager = 0;
+    QDBusConnection::systemBus().disconnect("org.bluez", QString(), "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                            this, SLOT(_k_propertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
     QMapIterator<QString, Adapter*> i(m_adapters);
     while (i.hasNext()) {
         i.next();
@@ -109,27 +314,295 @@ void ManagerPrivate::clean()
         delete adapter;
     }
 
+    m_devices.clear();
     m_usableAdapter = 0;
+    m_provisional = false;
 
     emit m_q->usableAdapterChanged(0);
 }
 
+bool ManagerPrivate::startSignalThread()
+{
+    SignalThread *const thread = new SignalThread(this);
+    if (!thread->startAndWait()) {
+        qWarning() << "Could not listen to BlueZ from a thread, listening from the thread of the Manager";
+        delete thread;
+        return false;
+    }
+
+    m_signalThread = thread;
+    return true;
+}
+
+void ManagerPrivate::stopSignalThread()
+{
+    if (!m_signalThread) {
+        return;
+    }
+
+    delete m_signalThread;
+    m_signalThread = 0;
+    // What it had already posted is about objects that are gone
+    QCoreApplication::removePostedEvents(this, SignalBatchEvent::eventType());
+    m_heldSignalEvents.clear();
+}
+
 Adapter *ManagerPrivate::findUsableAdapter()
 {
-    Q_FOREACH (Adapter *const adapter, m_q->adapters()) {
-        if (adapter->isPowered()) {
-            return adapter;
+    if (!m_bluezServiceRunning && !m_provisional && !m_replaying) {
+        return 0;
+    }
+
+    // Adapter state is cached, so this does not hit the bus
+    QMap<QString, Adapter*>::const_iterator it;
+    for (it = m_adapters.constBegin(); it != m_adapters.constEnd(); ++it) {
+        if (it.value()->isPowered()) {
+            return it.value();
         }
     }
     return 0;
 }
 
-void ManagerPrivate::_k_interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces)
+Device *ManagerPrivate::deviceForUBI(const QString &UBI)
+{
+    return m_devices.value(UBI);
+}
+
+bool ManagerPrivate::loadSnapshot()
+{
+    Snapshot snapshot;
+    if (m_snapshotPath.isEmpty() || !readSnapshot(m_snapshotPath, &snapshot)) {
+        return false;
+    }
+
+    m_provisional = true;
+
+    QList<Adapter*> addedAdapters;
+    QMap<QString, QVariantMap>::const_iterator it;
+    for (it = snapshot.adapters.constBegin(); it != snapshot.adapters.constEnd(); ++it) {
+        Adapter *const adapter = new Adapter(it.key(), it.value(), m_q);
+        connect(adapter, SIGNAL(poweredChanged(bool)), SLOT(_k_bluezAdapterPoweredChanged(bool)));
+        m_adapters.insert(it.key(), adapter);
+        addedAdapters << adapter;
+    }
+    for (it = snapshot.devices.constBegin(); it != snapshot.devices.constEnd(); ++it) {
+        Adapter *const adapter = m_adapters.value(it.value().value("Adapter").toString());
+        if (!adapter) {
+            continue;
+        }
+        Device *const device = adapter->addDevice(it.key(), it.value());
+        m_devices.insert(it.key(), device);
+        adapter->announceDevice(device);
+    }
+
+    Q_FOREACH (Adapter *const adapter, addedAdapters) {
+        emit m_q->adapterAdded(adapter);
+    }
+
+    m_usableAdapter = findUsableAdapter();
+    emit m_q->usableAdapterChanged(m_usableAdapter);
+
+    return true;
+}
+
+bool ManagerPrivate::saveSnapshot() const
+{
+    if (m_snapshotPath.isEmpty() || m_provisional || m_replaying || !m_initialized || !m_bluezServiceRunning) {
+        return false;
+    }
+
+    Snapshot snapshot;
+    QMap<QString, Adapter*>::const_iterator adapterIt;
+    for (adapterIt = m_adapters.constBegin(); adapterIt != m_adapters.constEnd(); ++adapterIt) {
+        snapshot.adapters.insert(adapterIt.key(), adapterIt.value()->cachedProperties());
+    }
+
+    // Devices that were just seen while discovering are not worth remembering
+    QHash<QString, Device*>::const_iterator deviceIt;
+    for (deviceIt = m_devices.constBegin(); deviceIt != m_devices.constEnd(); ++deviceIt) {
+        Device *const device = deviceIt.value();
+        QVariantMap properties = device->cachedProperties();
+        if (!properties.value("Paired").toBool() && !properties.value("Trusted").toBool()) {
+            continue;
+        }
+        properties.remove("RSSI");
+        properties.insert("Adapter", m_adapters.key(device->adapter()));
+        snapshot.devices.insert(deviceIt.key(), properties);
+    }
+
+    return writeSnapshot(m_snapshotPath, snapshot);
+}
+
+void ManagerPrivate::reconcileProperties(Adapter *adapter, const QVariantMap &properties)
+{
+    QVariantMap changed;
+    QStringList invalidated;
+    diffProperties(adapter->cachedProperties(), properties, &changed, &invalidated);
+    if (!changed.isEmpty() || !invalidated.isEmpty()) {
+        adapter->updateProperties(changed, invalidated);
+    }
+}
+
+void ManagerPrivate::reconcileProperties(Device *device, const QVariantMap &properties)
+{
+    QVariantMap changed;
+    QStringList invalidated;
+    diffProperties(device->cachedProperties(), properties, &changed, &invalidated);
+    if (!changed.isEmpty() || !invalidated.isEmpty()) {
+        device->updateProperties(changed, invalidated);
+    }
+}
+
+bool ManagerPrivate::startRecording(const QString &fileName)
+{
+    stopRecording();
+
+    TraceWriter *const writer = new TraceWriter;
+    if (!writer->open(fileName)) {
+        delete writer;
+        return false;
+    }
+
+    // The trace starts with what is already known, so that it can be replayed from scratch
+    QMap<QString, Adapter*>::const_iterator adapterIt;
+    for (adapterIt = m_adapters.constBegin(); adapterIt != m_adapters.constEnd(); ++adapterIt) {
+        QVariantMapMap interfaces;
+        interfaces.insert("org.bluez.Adapter1", adapterIt.value()->cachedProperties());
+        writer->interfacesAdded(adapterIt.key(), interfaces);
+    }
+    QHash<QString, Device*>::const_iterator deviceIt;
+    for (deviceIt = m_devices.constBegin(); deviceIt != m_devices.constEnd(); ++deviceIt) {
+        QVariantMap properties = deviceIt.value()->cachedProperties();
+        properties.insert("Adapter", m_adapters.key(deviceIt.value()->adapter()));
+        QVariantMapMap interfaces;
+        interfaces.insert("org.bluez.Device1", properties);
+        writer->interfacesAdded(deviceIt.key(), interfaces);
+    }
+
+    m_traceWriter = writer;
+    scheduleTraceFlush();
+    return true;
+}
+
+void ManagerPrivate::scheduleTraceFlush()
+{
+    if (m_traceFlushQueued) {
+        return;
+    }
+
+    // Once the signals that are already queued have been handled, rather than once per signal
+    m_traceFlushQueued = true;
+    QMetaObject::invokeMethod(this, "_k_flushTrace", Qt::QueuedConnection);
+}
+
+void ManagerPrivate::stopRecording()
+{
+    if (m_traceWriter) {
+        m_traceWriter->close();
+        delete m_traceWriter;
+        m_traceWriter = 0;
+    }
+}
+
+void ManagerPrivate::beginReplay()
+{
+    if (m_replaying) {
+        return;
+    }
+
+    // Whatever BlueZ said so far is dropped, and BlueZ is not listened to anymore
+    clean();
+    m_replaying = true;
+    setInitialized();
+}
+
+void ManagerPrivate::processEvent(const TraceEvent &event)
+{
+    switch (event.type) {
+    case TraceEvent::InterfacesAdded:
+        interfacesAdded(QDBusObjectPath(event.path), event.interfaces);
+        break;
+    case TraceEvent::InterfacesRemoved:
+        interfacesRemoved(QDBusObjectPath(event.path), event.names);
+        break;
+    case TraceEvent::PropertiesChanged:
+        propertiesChanged(event.path, event.interface, event.properties, event.names);
+        break;
+    }
+}
+
+void ManagerPrivate::propertiesChanged(const QString &path, const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
+{
+    if (interface == "org.bluez.Device1") {
+        Device *const device = m_devices.value(path);
+        if (device) {
+            device->updateProperties(changed, invalidated);
+        }
+    } else if (interface == "org.bluez.Adapter1") {
+        Adapter *const adapter = m_adapters.value(path);
+        if (adapter) {
+            adapter->updateProperties(changed, invalidated);
+        }
+    }
+}
+
+void ManagerPrivate::invalidateInfo()
+{
+    if (m_infoStale) {
+        return;
+    }
+
+    // However many changes arrive in a row, the info is rebuilt once, when it is next read
+    m_infoStale = true;
+    PublishedInfo *const published = publishedInfoInstance();
+    QMutexLocker locker(&published->mutex);
+    published->builder = this;
+}
+
+void ManagerPrivate::publishInfo(const ManagerInfo &info)
+{
+    PublishedInfo *const published = publishedInfoInstance();
+    ManagerInfo previous;
+    {
+        QMutexLocker locker(&published->mutex);
+        previous = published->info;
+        published->info = info;
+        published->builder = 0;
+        published->buildQueued = false;
+    }
+    // The previous info, if nobody else holds it, is freed outside of the lock
+}
+
+ManagerInfo ManagerPrivate::publishedInfo()
+{
+    PublishedInfo *const published = publishedInfoInstance();
+    QMutexLocker locker(&published->mutex);
+    ManagerPrivate *const builder = published->builder;
+    if (!builder) {
+        return published->info;
+    }
+
+    if (builder->thread() == QThread::currentThread()) {
+        locker.unlock();
+        builder->_k_publishInfo();
+        locker.relock();
+    } else if (!published->buildQueued) {
+        // The adapters and devices can only be read from their own thread
+        published->buildQueued = true;
+        QMetaObject::invokeMethod(builder, "_k_publishInfo", Qt::QueuedConnection);
+    }
+    return published->info;
+}
+
+void ManagerPrivate::interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces)
 {
   QVariantMapMap::const_iterator i;
   for(i = interfaces.constBegin(); i != interfaces.constEnd(); ++i) {
     if(i.key() == "org.bluez.Adapter1") {
-      Adapter * const adapter = new Adapter(objectPath.path(), m_q);
+      if (m_adapters.contains(objectPath.path())) {
+          continue;
+      }
+      Adapter * const adapter = new Adapter(objectPath.path(), i.value(), m_q);
       connect(adapter, SIGNAL(poweredChanged(bool)), SLOT(_k_bluezAdapterPoweredChanged(bool)));
       m_adapters.insert(objectPath.path(), adapter);
       if (!m_usableAdapter || !m_usableAdapter->isPowered()) {
@@ -143,15 +616,16 @@ void ManagerPrivate::_k_interfacesAdded(const QDBusObjectPath &objectPath, const
     } else if(i.key() == "org.bluez.Device1") {
       QString adapterPath = i.value().value("Adapter").value<QDBusObjectPath>().path();
       Adapter * const adapter = m_adapters.value(adapterPath);
-      if (adapter) {
-          adapter->addDevice(objectPath.path());
-          m_devAdapter.insert(objectPath.path(),adapter);
+      if (adapter && !m_devices.contains(objectPath.path())) {
+          Device *const device = adapter->addDevice(objectPath.path(), i.value());
+          m_devices.insert(objectPath.path(), device);
+          adapter->announceDevice(device);
       }
     }
   }
 }
 
-void ManagerPrivate::_k_interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces)
+void ManagerPrivate::interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces)
 {
     QString object = objectPath.path();
     Q_FOREACH(QString interface, interfaces) {
@@ -163,7 +637,7 @@ void ManagerPrivate::_k_interfacesRemoved(const QDBusObjectPath &objectPath, con
             if (adapter) {
                 emit m_q->adapterRemoved(adapter);
 
-                if (adapter->devices().isEmpty()) {
+                if (!adapter->deviceCount()) {
                     adapter->deleteLater();
                 }
             }
@@ -180,11 +654,12 @@ void ManagerPrivate::_k_interfacesRemoved(const QDBusObjectPath &objectPath, con
                 }
             }
         } else if(interface == "org.bluez.Device1") {
-            Adapter * const adapter = m_devAdapter.take(object);
-            if (adapter) {
+            Device *const device = m_devices.take(object);
+            if (device) {
+                Adapter *const adapter = device->adapter();
                 adapter->removeDevice(object);
 
-                if (adapter->devices().isEmpty() && !m_adapters.values().contains(adapter)) {
+                if (!adapter->deviceCount() && m_adapters.value(adapter->objectPath()) != adapter) {
                     adapter->deleteLater();
                 }
             }
@@ -192,18 +667,195 @@ void ManagerPrivate::_k_interfacesRemoved(const QDBusObjectPath &objectPath, con
     }
 }
 
+void ManagerPrivate::_k_interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces)
+{
+    recordSignal();
+    if (m_traceWriter) {
+        m_traceWriter->interfacesAdded(objectPath.path(), interfaces);
+        scheduleTraceFlush();
+    }
+
+    interfacesAdded(objectPath, interfaces);
+}
+
+void ManagerPrivate::_k_interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces)
+{
+    recordSignal();
+    if (m_traceWriter) {
+        m_traceWriter->interfacesRemoved(objectPath.path(), interfaces);
+        scheduleTraceFlush();
+    }
+
+    interfacesRemoved(objectPath, interfaces);
+}
+
+void ManagerPrivate::_k_propertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated, const QDBusMessage &message)
+{
+    recordSignal();
+    if (m_traceWriter) {
+        m_traceWriter->propertiesChanged(message.path(), interface, changed, invalidated);
+        scheduleTraceFlush();
+    }
+
+    propertiesChanged(message.path(), interface, changed, invalidated);
+}
+
+bool ManagerPrivate::event(QEvent *event)
+{
+    if (event->type() != SignalBatchEvent::eventType()) {
+        return QObject::event(event);
+    }
+
+    const SignalBatchEvent *const batch = static_cast<SignalBatchEvent*>(event);
+    recordSignal(batch->signalCount);
+    if (m_managedObjectsWatcher) {
+        // The two connections are not ordered against each other, so the reply to
+        // GetManagedObjects could still be behind changes that came after it
+        m_heldSignalEvents << batch->events;
+        return true;
+    }
+
+    applySignalEvents(batch->events);
+    return true;
+}
+
+void ManagerPrivate::applySignalEvents(const QList<TraceEvent> &events)
+{
+    Q_FOREACH (const TraceEvent &change, events) {
+        if (m_traceWriter) {
+            m_traceWriter->writeEvent(change);
+        }
+        processEvent(change);
+    }
+    if (m_traceWriter) {
+        m_traceWriter->flush();
+    }
+}
+
+void ManagerPrivate::_k_bluezServiceChecked(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<bool> reply = *watcher;
+    watcher->deleteLater();
+    recordCall("org.freedesktop.DBus", QLatin1String("NameHasOwner"), CallStatistics::MethodCall, false,
+               watcher->property("started").toLongLong(), reply.isError());
+
+    // The service watcher could have been faster than us
+    if (!m_bluezServiceRunning && !reply.isError()) {
+        m_bluezServiceRunning = reply.value();
+    }
+    initialize();
+}
+
+void ManagerPrivate::_k_managedObjectsReceived(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<DBusManagerStruct> reply = *watcher;
+    watcher->deleteLater();
+    m_managedObjectsWatcher = 0;
+    recordCall("org.freedesktop.DBus.ObjectManager", QLatin1String("GetManagedObjects"), CallStatistics::MethodCall, false,
+               watcher->property("started").toLongLong(), reply.isError());
+
+    loadManagedObjects(reply);
+}
+
 void ManagerPrivate::_k_bluezServiceRegistered()
 {
+    if (m_replaying) {
+        return;
+    }
+
     m_bluezServiceRunning = true;
     initialize();
 }
 
 void ManagerPrivate::_k_bluezServiceUnregistered()
 {
+    if (m_replaying) {
+        return;
+    }
+
     m_bluezServiceRunning = false;
     clean();
 }
 
+void ManagerPrivate::_k_adapterAdded(Adapter *adapter)
+{
+    connect(adapter, SIGNAL(propertyChanged(QString,QVariant)), SLOT(_k_adapterChanged()));
+    connect(adapter, SIGNAL(deviceFound(Device*)), SLOT(_k_deviceChanged(Device*)));
+    connect(adapter, SIGNAL(deviceRemoved(Device*)), SLOT(_k_deviceChanged(Device*)));
+    connect(adapter, SIGNAL(devicePropertiesChanged(Device*,quint32)), SLOT(_k_deviceChanged(Device*)));
+    invalidateInfo();
+}
+
+void ManagerPrivate::_k_adapterRemoved(Adapter *adapter)
+{
+    // Its devices go away without being removed one by one
+    m_adapterInfos.remove(adapter);
+    m_deviceInfos.clear();
+    invalidateInfo();
+}
+
+void ManagerPrivate::_k_adapterChanged()
+{
+    m_adapterInfos.remove(static_cast<Adapter*>(sender()));
+    invalidateInfo();
+}
+
+void ManagerPrivate::_k_deviceChanged(Device *device)
+{
+    // Only the changed devices and the adapters that list them are built again
+    m_deviceInfos.remove(device);
+    m_adapterInfos.remove(device->adapter());
+    invalidateInfo();
+}
+
+void ManagerPrivate::_k_infoChanged()
+{
+    invalidateInfo();
+}
+
+void ManagerPrivate::_k_publishInfo()
+{
+    // A build queued for another thread could have been done by a reader in this one since
+    if (!m_infoStale) {
+        return;
+    }
+    m_infoStale = false;
+
+    QList<AdapterInfo> adapters;
+    int usableAdapterIndex = -1;
+    Adapter *const usableAdapter = m_q->usableAdapter();
+    QMap<QString, Adapter*>::const_iterator adapterIt;
+    for (adapterIt = m_adapters.constBegin(); adapterIt != m_adapters.constEnd(); ++adapterIt) {
+        Adapter *const adapter = adapterIt.value();
+        QHash<Adapter*, AdapterInfo>::iterator infoIt = m_adapterInfos.find(adapter);
+        if (infoIt == m_adapterInfos.end()) {
+            QList<DeviceInfo> devices;
+            Q_FOREACH (Device *const device, adapter->devices()) {
+                QHash<Device*, DeviceInfo>::iterator deviceIt = m_deviceInfos.find(device);
+                if (deviceIt == m_deviceInfos.end()) {
+                    deviceIt = m_deviceInfos.insert(device, DeviceInfo(device, adapterIt.key()));
+                }
+                devices << deviceIt.value();
+            }
+            infoIt = m_adapterInfos.insert(adapter, AdapterInfo(adapterIt.key(), adapter, devices));
+        }
+        if (adapter == usableAdapter) {
+            usableAdapterIndex = adapters.count();
+        }
+        adapters << infoIt.value();
+    }
+
+    publishInfo(ManagerInfo(++infoGeneration, adapters, usableAdapterIndex));
+}
+
+void ManagerPrivate::_k_flushTrace()
+{
+    m_traceFlushQueued = false;
+    if (m_traceWriter) {
+        m_traceWriter->flush();
+    }
+}
+
 void ManagerPrivate::_k_bluezAdapterPoweredChanged(bool powered)
 {
     //If the power change has had no effect on usableAdpater, do nothing
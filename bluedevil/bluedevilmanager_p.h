@@ -23,13 +23,21 @@
 #include "bluezagentmanager1.h"
 #include "bluedevildbustypes.h"
 
+#include "bluedevilinfo.h"
+#include "bluedevilmanager.h"
+
 #include <QObject>
 #include <QDBusObjectPath>
+#include <QDBusMessage>
+
+class QDBusPendingCallWatcher;
 
 namespace BlueDevil {
 class Adapter;
-class Manager;
 class Device;
+class SignalThread;
+class TraceWriter;
+struct TraceEvent;
 
 class ManagerPrivate : public QObject
 {
@@ -38,28 +46,81 @@ public:
     ManagerPrivate(Manager *q);
     virtual ~ManagerPrivate();
 
+    void start();
     void initialize();
+    void loadManagedObjects(const QDBusPendingReply<DBusManagerStruct> &reply);
+    void abandonManagedObjectsCall();
+    void setInitialized();
     void clean();
+    bool startSignalThread();
+    void stopSignalThread();
+    void applySignalEvents(const QList<TraceEvent> &events);
     Adapter *findUsableAdapter();
     Device  *deviceForUBI(const QString &UBI);
 
+    bool loadSnapshot();
+    bool saveSnapshot() const;
+    void reconcileProperties(Adapter *adapter, const QVariantMap &properties);
+    void reconcileProperties(Device *device, const QVariantMap &properties);
+
+    bool startRecording(const QString &fileName);
+    void scheduleTraceFlush();
+    void stopRecording();
+    void beginReplay();
+    void processEvent(const TraceEvent &event);
+    void interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces);
+    void interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void propertiesChanged(const QString &path, const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+
+    void invalidateInfo();
+    static void publishInfo(const ManagerInfo &info);
+    static ManagerInfo publishedInfo();
 
     org::freedesktop::DBus::ObjectManager *m_dbusObjectManager;
     org::bluez::AgentManager1             *m_bluezAgentManager;
     Adapter                               *m_usableAdapter;
     QMap<QString, Adapter*>                m_adapters;
-    QHash<QString, Adapter*>               m_devAdapter;
+    QHash<QString, Device*>                m_devices;
     bool                                   m_bluezServiceRunning;
+    Manager::InitializationMode            m_initializationMode;
+    bool                                   m_initialized;
+    QDBusPendingCallWatcher               *m_managedObjectsWatcher;
+    QString                                m_snapshotPath;
+    bool                                   m_provisional; // adapters and devices come from the snapshot
+    TraceWriter                           *m_traceWriter;
+    bool                                   m_traceFlushQueued;
+    bool                                   m_replaying;   // adapters and devices come from a trace, not BlueZ
+    // Of the adapters and devices that did not change since the last info was built
+    QHash<Adapter*, AdapterInfo>           m_adapterInfos;
+    QHash<Device*, DeviceInfo>             m_deviceInfos;
+    bool                                   m_infoStale;
+    bool                                   m_useSignalThread;
+    SignalThread                          *m_signalThread;
+    QList<TraceEvent>                      m_heldSignalEvents; // while GetManagedObjects is in flight
 
     Manager *const m_q;
 
+protected:
+    virtual bool event(QEvent *event);
+
 public Q_SLOTS:
+    void _k_bluezServiceChecked(QDBusPendingCallWatcher *watcher);
+    void _k_managedObjectsReceived(QDBusPendingCallWatcher *watcher);
     void _k_bluezServiceRegistered();
     void _k_bluezServiceUnregistered();
     void _k_bluezAdapterPoweredChanged(bool powered);
 
+    void _k_adapterAdded(Adapter *adapter);
+    void _k_adapterRemoved(Adapter *adapter);
+    void _k_adapterChanged();
+    void _k_deviceChanged(Device *device);
+    void _k_infoChanged();
+    void _k_publishInfo();
+    void _k_flushTrace();
+
     void _k_interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces);
     void _k_interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void _k_propertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated, const QDBusMessage &message);
 };
 
 }
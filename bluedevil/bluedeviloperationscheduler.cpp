@@ -0,0 +1,311 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedeviloperationscheduler.h"
+#include "bluedeviladapter.h"
+#include "bluedevildevice.h"
+#include "bluedevilpendingcall.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPointer>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusPendingCall>
+
+namespace BlueDevil {
+
+static const char canceledError[] = "org.kde.BlueDevil.Error.Canceled";
+
+/**
+ * @internal
+ */
+class OperationScheduler::Private
+{
+public:
+    Private(OperationScheduler *q, Adapter *adapter);
+
+    struct Request {
+        QPointer<Device>  device;
+        Operation         operation;
+        QString           UUID;
+        int               timeout;
+        PendingCall      *call;
+    };
+
+    PendingCall *schedule(Device *device, Operation operation, const QString &UUID, Priority priority, int timeout);
+    void startQueued();
+    void finishUnsent(const Request &request, const QString &errorName, const QString &errorText);
+    void checkIdle();
+    void _k_callFinished();
+    void _k_deviceDestroyed();
+
+    Adapter *const               m_adapter;
+    QList<Request>               m_queues[HighPriority + 1]; // FIFO for each priority
+    int                          m_queuedCount;
+    QHash<PendingCall*, Request> m_running;
+    int                          m_maxConcurrentOperations;
+    int                          m_defaultTimeout;
+    bool                         m_busy; // whether idle has to be emitted
+
+    OperationScheduler *const m_q;
+};
+
+OperationScheduler::Private::Private(OperationScheduler *q, Adapter *adapter)
+    : m_adapter(adapter)
+    , m_queuedCount(0)
+    , m_maxConcurrentOperations(1)
+    , m_defaultTimeout(-1)
+    , m_busy(false)
+    , m_q(q)
+{
+}
+
+PendingCall *OperationScheduler::Private::schedule(Device *device, Operation operation, const QString &UUID,
+                                                   Priority priority, int timeout)
+{
+    if (!device) {
+        return new PendingCall(QDBusPendingCall::fromError(QDBusError(QDBusError::InvalidArgs,
+                                                                      QLatin1String("No device given"))), m_q);
+    }
+
+    Request request;
+    request.device = device;
+    request.operation = operation;
+    request.UUID = UUID;
+    request.timeout = timeout == -1 ? m_defaultTimeout : timeout;
+    // Owned by the scheduler, so that it survives the device
+    request.call = new PendingCall(m_q);
+    m_q->connect(request.call, SIGNAL(finished(bool,QString)), m_q, SLOT(_k_callFinished()));
+
+    m_queues[qBound(int(LowPriority), int(priority), int(HighPriority))].append(request);
+    ++m_queuedCount;
+    m_busy = true;
+
+    startQueued();
+    return request.call;
+}
+
+void OperationScheduler::Private::startQueued()
+{
+    while (m_queuedCount > 0 && m_running.count() < m_maxConcurrentOperations) {
+        Request request;
+        for (int priority = HighPriority; priority >= LowPriority; --priority) {
+            if (!m_queues[priority].isEmpty()) {
+                request = m_queues[priority].takeFirst();
+                break;
+            }
+        }
+        --m_queuedCount;
+
+        if (!request.device) {
+            finishUnsent(request, QLatin1String("org.freedesktop.DBus.Error.UnknownObject"),
+                         QLatin1String("The device went away before the request was sent"));
+            continue;
+        }
+
+        m_q->connect(request.device, SIGNAL(destroyed()), m_q, SLOT(_k_deviceDestroyed()), Qt::UniqueConnection);
+        m_running.insert(request.call, request);
+        const char *member = 0;
+        const QDBusPendingCall call = request.device->callOperation(request.operation, request.UUID, request.timeout, &member);
+        request.call->setCall(call, "org.bluez.Device1", member);
+    }
+}
+
+void OperationScheduler::Private::finishUnsent(const Request &request, const QString &errorName, const QString &errorText)
+{
+    request.call->setError(errorName, errorText);
+    emit m_q->operationFinished(request.device, request.operation, false, errorName);
+}
+
+void OperationScheduler::Private::checkIdle()
+{
+    if (m_busy && m_queuedCount == 0 && m_running.isEmpty()) {
+        m_busy = false;
+        emit m_q->idle();
+    }
+}
+
+void OperationScheduler::Private::_k_callFinished()
+{
+    PendingCall *const call = static_cast<PendingCall*>(m_q->sender());
+    QHash<PendingCall*, Request>::iterator it = m_running.find(call);
+    if (it == m_running.end()) {
+        // Finished without being sent, finishUnsent takes care of it
+        return;
+    }
+
+    const Request request = it.value();
+    m_running.erase(it);
+
+    emit m_q->operationFinished(request.device, request.operation, !call->isError(), call->errorName());
+    startQueued();
+    checkIdle();
+}
+
+void OperationScheduler::Private::_k_deviceDestroyed()
+{
+    // BlueZ may never answer for a device it removed, so its requests are not waited for
+    QList<Request> orphaned;
+    QHash<PendingCall*, Request>::iterator it = m_running.begin();
+    while (it != m_running.end()) {
+        if (!it.value().device) {
+            orphaned << it.value();
+            it = m_running.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    Q_FOREACH (const Request &request, orphaned) {
+        finishUnsent(request, QLatin1String("org.freedesktop.DBus.Error.UnknownObject"),
+                     QLatin1String("The device went away before BlueZ replied"));
+    }
+    startQueued();
+    checkIdle();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+OperationScheduler::OperationScheduler(Adapter *adapter)
+    : QObject(adapter)
+    , d(new Private(this, adapter))
+{
+    qRegisterMetaType<BlueDevil::OperationScheduler::Operation>("BlueDevil::OperationScheduler::Operation");
+}
+
+OperationScheduler::~OperationScheduler()
+{
+    // Only the pending calls are told, this object is going away. The running ones are taken out
+    // first, so that _k_callFinished does not start the queued ones in their place.
+    const QHash<PendingCall*, Private::Request> running = d->m_running;
+    d->m_running.clear();
+    Q_FOREACH (const Private::Request &request, running) {
+        request.call->setError(QLatin1String(canceledError), QLatin1String("The adapter went away"));
+    }
+    for (int priority = HighPriority; priority >= LowPriority; --priority) {
+        Q_FOREACH (const Private::Request &request, d->m_queues[priority]) {
+            request.call->setError(QLatin1String(canceledError), QLatin1String("The adapter went away"));
+        }
+    }
+    delete d;
+}
+
+Adapter *OperationScheduler::adapter() const
+{
+    return d->m_adapter;
+}
+
+int OperationScheduler::maxConcurrentOperations() const
+{
+    return d->m_maxConcurrentOperations;
+}
+
+void OperationScheduler::setMaxConcurrentOperations(int count)
+{
+    d->m_maxConcurrentOperations = qMax(1, count);
+    d->startQueued();
+    d->checkIdle();
+}
+
+int OperationScheduler::defaultTimeout() const
+{
+    return d->m_defaultTimeout;
+}
+
+void OperationScheduler::setDefaultTimeout(int msec)
+{
+    d->m_defaultTimeout = msec;
+}
+
+int OperationScheduler::queuedCount() const
+{
+    return d->m_queuedCount;
+}
+
+int OperationScheduler::runningCount() const
+{
+    return d->m_running.count();
+}
+
+PendingCall *OperationScheduler::pair(Device *device, Priority priority, int timeout)
+{
+    return d->schedule(device, PairOperation, QString(), priority, timeout);
+}
+
+PendingCall *OperationScheduler::connectDevice(Device *device, Priority priority, int timeout)
+{
+    return d->schedule(device, ConnectOperation, QString(), priority, timeout);
+}
+
+PendingCall *OperationScheduler::disconnectDevice(Device *device, Priority priority, int timeout)
+{
+    return d->schedule(device, DisconnectOperation, QString(), priority, timeout);
+}
+
+PendingCall *OperationScheduler::connectProfile(Device *device, const QString &UUID, Priority priority, int timeout)
+{
+    return d->schedule(device, ConnectProfileOperation, UUID, priority, timeout);
+}
+
+PendingCall *OperationScheduler::disconnectProfile(Device *device, const QString &UUID, Priority priority, int timeout)
+{
+    return d->schedule(device, DisconnectProfileOperation, UUID, priority, timeout);
+}
+
+bool OperationScheduler::cancel(PendingCall *call)
+{
+    for (int priority = HighPriority; priority >= LowPriority; --priority) {
+        QList<Private::Request> &queue = d->m_queues[priority];
+        for (int i = 0; i < queue.count(); ++i) {
+            if (queue.at(i).call == call) {
+                const Private::Request request = queue.takeAt(i);
+                --d->m_queuedCount;
+                d->finishUnsent(request, QLatin1String(canceledError),
+                                QLatin1String("The request was canceled before being sent"));
+                d->checkIdle();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void OperationScheduler::cancelQueued()
+{
+    if (d->m_queuedCount == 0) {
+        return;
+    }
+
+    QList<Private::Request> canceled;
+    for (int priority = HighPriority; priority >= LowPriority; --priority) {
+        canceled << d->m_queues[priority];
+        d->m_queues[priority].clear();
+    }
+    d->m_queuedCount = 0;
+
+    Q_FOREACH (const Private::Request &request, canceled) {
+        d->finishUnsent(request, QLatin1String(canceledError),
+                        QLatin1String("The request was canceled before being sent"));
+    }
+    d->checkIdle();
+}
+
+}
+
+#include "bluedeviloperationscheduler.moc"
@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILOPERATIONSCHEDULER_H
+#define BLUEDEVILOPERATIONSCHEDULER_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QMetaType>
+#include <QtCore/QObject>
+
+namespace BlueDevil {
+
+class Adapter;
+class Device;
+class PendingCall;
+
+/**
+ * @class OperationScheduler bluedeviloperationscheduler.h bluedevil/bluedeviloperationscheduler.h
+ *
+ * This class queues pair, connect and disconnect requests on the devices of an adapter, and only
+ * sends a limited number of them to BlueZ at the same time. Connecting dozens of devices at once
+ * otherwise makes the controller reject page requests.
+ *
+ * Requests are sent by priority, and in the order they were scheduled within the same priority:
+ *
+ * @code
+ * OperationScheduler *scheduler = adapter->operationScheduler();
+ * scheduler->setMaxConcurrentOperations(2);
+ * Q_FOREACH (Device *device, devicesToRestore) {
+ *     scheduler->connectDevice(device);
+ * }
+ * scheduler->connectDevice(keyboard, OperationScheduler::HighPriority);
+ * @endcode
+ *
+ * Each request returns a PendingCall right away, which finishes once BlueZ has replied or the
+ * request has been canceled. operationFinished is emitted as well for every request.
+ *
+ * Requests that have not been sent yet when the adapter goes away are canceled.
+ */
+class BLUEDEVIL_EXPORT OperationScheduler
+    : public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(Operation Priority)
+
+    Q_PROPERTY(int maxConcurrentOperations READ maxConcurrentOperations WRITE setMaxConcurrentOperations)
+    Q_PROPERTY(int defaultTimeout READ defaultTimeout WRITE setDefaultTimeout)
+
+    friend class Adapter;
+
+public:
+    enum Operation {
+        PairOperation = 0,
+        ConnectOperation,
+        DisconnectOperation,
+        ConnectProfileOperation,
+        DisconnectProfileOperation
+    };
+
+    enum Priority {
+        LowPriority = 0,
+        NormalPriority,
+        HighPriority
+    };
+
+    virtual ~OperationScheduler();
+
+    /**
+     * @return The adapter whose devices this scheduler handles.
+     */
+    Adapter *adapter() const;
+
+    /**
+     * @return How many requests can be waiting for a reply from BlueZ at the same time. It is 1 by
+     *         default, as the controller pages one device at a time.
+     *
+     * @note Pairing waits for the agent, so it holds its slot until the user has answered.
+     */
+    int maxConcurrentOperations() const;
+
+    /**
+     * Sets how many requests can be waiting for a reply from BlueZ at the same time. Raising the
+     * limit sends queued requests right away.
+     */
+    void setMaxConcurrentOperations(int count);
+
+    /**
+     * @return The timeout in milliseconds of the requests scheduled without one, or -1 for the
+     *         D-Bus default, which is the default.
+     */
+    int defaultTimeout() const;
+
+    /**
+     * Sets the timeout in milliseconds of the requests scheduled without one. -1 means the D-Bus
+     * default timeout.
+     */
+    void setDefaultTimeout(int msec);
+
+    /**
+     * @return The number of requests that have not been sent yet.
+     */
+    int queuedCount() const;
+
+    /**
+     * @return The number of requests that are waiting for a reply from BlueZ.
+     */
+    int runningCount() const;
+
+    /**
+     * Schedules the pairing of @p device. See Device::pair.
+     *
+     * The timeout, in milliseconds, starts counting when the request is sent. If it expires, the
+     * pending call fails with org.freedesktop.DBus.Error.NoReply. -1 means defaultTimeout.
+     *
+     * @return A pending call that finishes with the reply. It deletes itself when finished.
+     */
+    PendingCall *pair(Device *device, Priority priority = NormalPriority, int timeout = -1);
+
+    /**
+     * Schedules the connection of @p device. See pair for the arguments and Device::connectDevice.
+     */
+    PendingCall *connectDevice(Device *device, Priority priority = NormalPriority, int timeout = -1);
+
+    /**
+     * Schedules the disconnection of @p device. See pair for the arguments and Device::disconnect.
+     */
+    PendingCall *disconnectDevice(Device *device, Priority priority = NormalPriority, int timeout = -1);
+
+    /**
+     * Schedules the connection of the profile @p UUID of @p device. See pair for the arguments and
+     * Device::connectProfile.
+     */
+    PendingCall *connectProfile(Device *device, const QString &UUID, Priority priority = NormalPriority, int timeout = -1);
+
+    /**
+     * Schedules the disconnection of the profile @p UUID of @p device. See pair for the arguments
+     * and Device::disconnectProfile.
+     */
+    PendingCall *disconnectProfile(Device *device, const QString &UUID, Priority priority = NormalPriority, int timeout = -1);
+
+    /**
+     * Cancels @p call if it has not been sent yet. It then finishes with the error
+     * org.kde.BlueDevil.Error.Canceled.
+     *
+     * @return Whether @p call was queued.
+     */
+    bool cancel(PendingCall *call);
+
+    /**
+     * Cancels all the requests that have not been sent yet. Requests waiting for a reply are not
+     * affected.
+     */
+    void cancelQueued();
+
+Q_SIGNALS:
+    /**
+     * Emitted when a request has finished, either with the reply of BlueZ or because it was
+     * canceled. @p device is 0 if the device went away while the request was queued or waiting
+     * for a reply, in which case the request fails with org.freedesktop.DBus.Error.UnknownObject.
+     */
+    void operationFinished(Device *device, BlueDevil::OperationScheduler::Operation operation,
+                           bool ok, const QString &errorName);
+
+    /**
+     * Emitted when the last request has finished and none is queued.
+     */
+    void idle();
+
+private:
+    /**
+     * @internal
+     */
+    OperationScheduler(Adapter *adapter);
+
+    class Private;
+    Private *const d;
+
+    Q_PRIVATE_SLOT(d, void _k_callFinished())
+    Q_PRIVATE_SLOT(d, void _k_deviceDestroyed())
+};
+
+}
+
+Q_DECLARE_METATYPE(BlueDevil::OperationScheduler::Operation)
+
+#endif // BLUEDEVILOPERATIONSCHEDULER_H
@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevilpendingcall.h"
+#include "bluedevilstatistics_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtDBus/QDBusPendingCall>
+#include <QtDBus/QDBusPendingCallWatcher>
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ */
+class PendingCall::Private
+{
+public:
+    Private(PendingCall *q);
+
+    void finish(const QString &errorName, const QString &errorText);
+    void _k_finished(QDBusPendingCallWatcher *watcher);
+
+    QDBusPendingCallWatcher *m_watcher;
+    const char              *m_interface; // set if the call is counted in the bus statistics
+    const char              *m_member;
+    qint64                   m_started;
+    bool                     m_finished;
+    QString                  m_errorName;
+    QString                  m_errorText;
+
+    PendingCall *const m_q;
+};
+
+PendingCall::Private::Private(PendingCall *q)
+    : m_watcher(0)
+    , m_interface(0)
+    , m_member(0)
+    , m_started(0)
+    , m_finished(false)
+    , m_q(q)
+{
+}
+
+void PendingCall::Private::finish(const QString &errorName, const QString &errorText)
+{
+    if (m_finished) {
+        return;
+    }
+
+    m_finished = true;
+    m_errorName = errorName;
+    m_errorText = errorText;
+
+    emit m_q->finished(m_errorName.isEmpty(), m_errorName);
+    m_q->deleteLater();
+}
+
+void PendingCall::Private::_k_finished(QDBusPendingCallWatcher *watcher)
+{
+    if (m_interface && !m_finished) {
+        recordCall(m_interface, QLatin1String(m_member), CallStatistics::MethodCall, false, m_started, watcher->isError());
+    }
+
+    if (watcher->isError()) {
+        finish(watcher->error().name(), watcher->error().message());
+    } else {
+        finish(QString(), QString());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PendingCall::PendingCall(const QDBusPendingCall &call, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+    setCall(call);
+}
+
+PendingCall::PendingCall(const QDBusPendingCall &call, const char *interface, const char *member, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+    setCall(call, interface, member);
+}
+
+PendingCall::PendingCall(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+PendingCall::~PendingCall()
+{
+    if (d->m_interface && !d->m_finished) {
+        // Never answered, as far as we know
+        recordCall(d->m_interface, QLatin1String(d->m_member), CallStatistics::MethodCall, false, d->m_started, true);
+    }
+    delete d;
+}
+
+bool PendingCall::isFinished() const
+{
+    return d->m_finished;
+}
+
+bool PendingCall::isError() const
+{
+    return !d->m_errorName.isEmpty();
+}
+
+QString PendingCall::errorName() const
+{
+    return d->m_errorName;
+}
+
+QString PendingCall::errorText() const
+{
+    return d->m_errorText;
+}
+
+void PendingCall::waitForFinished()
+{
+    if (d->m_finished) {
+        return;
+    }
+
+    // Still queued in an OperationScheduler
+    while (!d->m_watcher && !d->m_finished) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    if (d->m_finished) {
+        return;
+    }
+
+    d->m_watcher->waitForFinished();
+    d->_k_finished(d->m_watcher);
+}
+
+void PendingCall::setCall(const QDBusPendingCall &call, const char *interface, const char *member)
+{
+    Q_ASSERT(!d->m_watcher);
+    if (interface && member) {
+        d->m_interface = interface;
+        d->m_member = member;
+        d->m_started = statisticsClock();
+        asyncCallStarted();
+    }
+    d->m_watcher = new QDBusPendingCallWatcher(call, this);
+    connect(d->m_watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(_k_finished(QDBusPendingCallWatcher*)));
+}
+
+void PendingCall::setError(const QString &errorName, const QString &errorText)
+{
+    if (d->m_interface && !d->m_finished) {
+        // Given up on before the reply came
+        recordCall(d->m_interface, QLatin1String(d->m_member), CallStatistics::MethodCall, false, d->m_started, true);
+    }
+    d->finish(errorName, errorText);
+}
+
+}
+
+#include "bluedevilpendingcall.moc"
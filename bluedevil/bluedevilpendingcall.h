@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILPENDINGCALL_H
+#define BLUEDEVILPENDINGCALL_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QObject>
+
+class QDBusPendingCall;
+class QDBusPendingCallWatcher;
+
+namespace BlueDevil {
+
+/**
+ * @class PendingCall bluedevilpendingcall.h bluedevil/bluedevilpendingcall.h
+ *
+ * This class represents an operation that has been sent to BlueZ and whose reply has not been
+ * received yet, like pairing or connecting a device.
+ *
+ * The operations that return a PendingCall never block, so many of them can be in flight at the
+ * same time:
+ *
+ * @code
+ * Q_FOREACH (Device *device, adapter->devices()) {
+ *     PendingCall *call = device->connectDevice();
+ *     connect(call, SIGNAL(finished(bool,QString)), this, SLOT(connectFinished(bool,QString)));
+ * }
+ * @endcode
+ *
+ * The pending call deletes itself once finished has been emitted, so you do not need to keep
+ * track of it if you are not interested in the result. Inside the connected slot, sender() is the
+ * PendingCall that finished.
+ */
+class BLUEDEVIL_EXPORT PendingCall
+    : public QObject
+{
+    Q_OBJECT
+
+    friend class Adapter;
+    friend class Device;
+    friend class Manager;
+    friend class OperationScheduler;
+
+public:
+    virtual ~PendingCall();
+
+    /**
+     * @return Whether the reply has been received. A call queued in an OperationScheduler can
+     *         also finish without having been sent, if it is canceled.
+     */
+    bool isFinished() const;
+
+    /**
+     * @return Whether the operation failed. Only meaningful once the call has finished.
+     */
+    bool isError() const;
+
+    /**
+     * @return The D-Bus error name, as in "org.bluez.Error.Failed", or an empty string if the
+     *         operation succeeded or has not finished yet.
+     */
+    QString errorName() const;
+
+    /**
+     * @return A human readable description of the error, if any.
+     */
+    QString errorText() const;
+
+    /**
+     * Blocks until the reply has been received. finished will be emitted before this method
+     * returns, if it had not been emitted yet. If the call is still queued in an
+     * OperationScheduler, events are processed until it has been sent and answered.
+     *
+     * @note This defeats the purpose of this class, and is only meant for code that cannot be
+     *       made asynchronous.
+     */
+    void waitForFinished();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the reply for this operation has been received. @p ok is true if the operation
+     * succeeded, otherwise @p errorName contains the D-Bus error name.
+     */
+    void finished(bool ok, const QString &errorName);
+
+private:
+    /**
+     * @internal
+     */
+    PendingCall(const QDBusPendingCall &call, QObject *parent);
+
+    /**
+     * @internal
+     *
+     * The call is counted in Manager::busStatistics as a call to @p member of @p interface.
+     */
+    PendingCall(const QDBusPendingCall &call, const char *interface, const char *member, QObject *parent);
+
+    /**
+     * @internal
+     *
+     * Creates a pending call that has not been sent yet. Either setCall or setError is called
+     * later on.
+     */
+    PendingCall(QObject *parent);
+
+    /**
+     * @internal
+     *
+     * If @p interface and @p member are given, the call is counted in Manager::busStatistics.
+     */
+    void setCall(const QDBusPendingCall &call, const char *interface = 0, const char *member = 0);
+
+    /**
+     * @internal
+     *
+     * Finishes the call with an error, whether it was sent or not. A reply coming later is
+     * ignored.
+     */
+    void setError(const QString &errorName, const QString &errorText);
+
+    class Private;
+    Private *const d;
+
+    Q_PRIVATE_SLOT(d, void _k_finished(QDBusPendingCallWatcher*))
+};
+
+}
+
+#endif // BLUEDEVILPENDINGCALL_H
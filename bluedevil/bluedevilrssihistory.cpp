@@ -0,0 +1,210 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevilrssihistory.h"
+
+#include <QtCore/QVector>
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ */
+class RSSIHistory::Private
+{
+public:
+    Private();
+
+    QVector<RSSISample> m_samples; // ring buffer, its size is the capacity
+    int                 m_first;   // index of the oldest sample
+    int                 m_count;
+    qint64              m_sum;     // of the stored readings
+    bool                m_appended;    // whether any sample was ever appended
+    RSSISample          m_latest;
+    qreal               m_average;
+    qreal               m_smoothingFactor;
+};
+
+RSSIHistory::Private::Private()
+    : m_first(0)
+    , m_count(0)
+    , m_sum(0)
+    , m_appended(false)
+    , m_average(0)
+    , m_smoothingFactor(0.25)
+{
+    m_latest.timestamp = 0;
+    m_latest.RSSI = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RSSIHistory::RSSIHistory(int capacity)
+    : d(new Private)
+{
+    d->m_samples.resize(qMax(0, capacity));
+}
+
+RSSIHistory::~RSSIHistory()
+{
+    delete d;
+}
+
+int RSSIHistory::capacity() const
+{
+    return d->m_samples.size();
+}
+
+void RSSIHistory::setCapacity(int capacity)
+{
+    capacity = qMax(0, capacity);
+    if (capacity == d->m_samples.size()) {
+        return;
+    }
+
+    // Keep the newest samples, unrolled so the oldest one ends up at index 0
+    const int kept = qMin(d->m_count, capacity);
+    QVector<RSSISample> samples(capacity);
+    qint64 sum = 0;
+    for (int i = 0; i < kept; ++i) {
+        samples[i] = at(d->m_count - kept + i);
+        sum += samples.at(i).RSSI;
+    }
+
+    d->m_samples = samples;
+    d->m_first = 0;
+    d->m_count = kept;
+    d->m_sum = sum;
+}
+
+int RSSIHistory::count() const
+{
+    return d->m_count;
+}
+
+bool RSSIHistory::isEmpty() const
+{
+    return d->m_count == 0;
+}
+
+RSSISample RSSIHistory::at(int index) const
+{
+    Q_ASSERT(index >= 0 && index < d->m_count);
+    return d->m_samples.at((d->m_first + index) % d->m_samples.size());
+}
+
+RSSISample RSSIHistory::latest() const
+{
+    return d->m_latest;
+}
+
+qint16 RSSIHistory::minimum() const
+{
+    if (!d->m_count) {
+        return 0;
+    }
+    qint16 minimum = at(0).RSSI;
+    for (int i = 1; i < d->m_count; ++i) {
+        minimum = qMin(minimum, at(i).RSSI);
+    }
+    return minimum;
+}
+
+qint16 RSSIHistory::maximum() const
+{
+    if (!d->m_count) {
+        return 0;
+    }
+    qint16 maximum = at(0).RSSI;
+    for (int i = 1; i < d->m_count; ++i) {
+        maximum = qMax(maximum, at(i).RSSI);
+    }
+    return maximum;
+}
+
+qreal RSSIHistory::mean() const
+{
+    if (!d->m_count) {
+        return 0;
+    }
+    return qreal(d->m_sum) / d->m_count;
+}
+
+qreal RSSIHistory::exponentialAverage() const
+{
+    return d->m_average;
+}
+
+qreal RSSIHistory::smoothingFactor() const
+{
+    return d->m_smoothingFactor;
+}
+
+void RSSIHistory::setSmoothingFactor(qreal smoothingFactor)
+{
+    if (smoothingFactor > 0 && smoothingFactor <= 1) {
+        d->m_smoothingFactor = smoothingFactor;
+    }
+}
+
+void RSSIHistory::append(qint64 timestamp, qint16 RSSI)
+{
+    if (d->m_appended) {
+        d->m_average += d->m_smoothingFactor * (RSSI - d->m_average);
+    } else {
+        d->m_average = RSSI;
+        d->m_appended = true;
+    }
+    d->m_latest.timestamp = timestamp;
+    d->m_latest.RSSI = RSSI;
+
+    const int capacity = d->m_samples.size();
+    if (!capacity) {
+        return;
+    }
+
+    int index;
+    if (d->m_count < capacity) {
+        index = (d->m_first + d->m_count) % capacity;
+        ++d->m_count;
+    } else {
+        // Full, overwrite the oldest one
+        index = d->m_first;
+        d->m_sum -= d->m_samples.at(index).RSSI;
+        d->m_first = (d->m_first + 1) % capacity;
+    }
+
+    RSSISample &sample = d->m_samples[index];
+    sample.timestamp = timestamp;
+    sample.RSSI = RSSI;
+    d->m_sum += RSSI;
+}
+
+void RSSIHistory::clear()
+{
+    d->m_first = 0;
+    d->m_count = 0;
+    d->m_sum = 0;
+    d->m_appended = false;
+    d->m_latest.timestamp = 0;
+    d->m_latest.RSSI = 0;
+    d->m_average = 0;
+}
+
+}
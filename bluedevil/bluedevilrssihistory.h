@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILRSSIHISTORY_H
+#define BLUEDEVILRSSIHISTORY_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QtGlobal>
+
+namespace BlueDevil {
+
+/**
+ * A signal strength reading of a remote device.
+ */
+struct RSSISample
+{
+    /**
+     * When the reading was received, in milliseconds of the monotonic clock. It can be compared
+     * with QElapsedTimer::msecsSinceReference().
+     */
+    qint64 timestamp;
+
+    /**
+     * The signal strength in dBm.
+     */
+    qint16 RSSI;
+};
+
+/**
+ * @class RSSIHistory bluedevilrssihistory.h bluedevil/bluedevilrssihistory.h
+ *
+ * The latest signal strength readings of a remote device, kept in a fixed capacity ring buffer.
+ * Once it is full, each new sample replaces the oldest one. Samples are stored by value, so
+ * appending never allocates.
+ *
+ * Besides the samples in the buffer, an exponential moving average is kept over all the samples
+ * ever appended, even when the capacity is 0.
+ *
+ * @see Device::RSSISamples
+ */
+class BLUEDEVIL_EXPORT RSSIHistory
+{
+public:
+    /**
+     * Creates a history that keeps up to @p capacity samples.
+     */
+    explicit RSSIHistory(int capacity = 0);
+    ~RSSIHistory();
+
+    /**
+     * @return How many samples the history keeps at most.
+     */
+    int capacity() const;
+
+    /**
+     * Changes how many samples are kept. The newest samples that fit are preserved.
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @return How many samples are stored, never more than capacity().
+     */
+    int count() const;
+
+    /**
+     * @return Whether there are no samples stored.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @return The sample at @p index, 0 being the oldest stored sample.
+     */
+    RSSISample at(int index) const;
+
+    /**
+     * @return The newest sample ever appended, even if the capacity is 0. Its timestamp is 0 if
+     *         no sample has been appended yet.
+     */
+    RSSISample latest() const;
+
+    /**
+     * @return The weakest stored reading, or 0 if the history is empty.
+     */
+    qint16 minimum() const;
+
+    /**
+     * @return The strongest stored reading, or 0 if the history is empty.
+     */
+    qint16 maximum() const;
+
+    /**
+     * @return The mean of the stored readings, or 0 if the history is empty. It is kept up to date
+     *         as samples are appended, so this does not walk the samples.
+     */
+    qreal mean() const;
+
+    /**
+     * @return The exponential moving average of all the readings appended, or 0 if none has
+     *         been appended yet.
+     */
+    qreal exponentialAverage() const;
+
+    /**
+     * @return The weight given to each new reading in exponentialAverage(). 0.25 by default.
+     */
+    qreal smoothingFactor() const;
+
+    /**
+     * Sets the weight given to each new reading in exponentialAverage(), between 0 (exclusive)
+     * and 1 (inclusive). Higher values follow changes faster, lower values smooth out more noise.
+     */
+    void setSmoothingFactor(qreal smoothingFactor);
+
+    /**
+     * Adds a reading, dropping the oldest one if the history is full.
+     */
+    void append(qint64 timestamp, qint16 RSSI);
+
+    /**
+     * Removes all the samples and resets the average.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(RSSIHistory)
+
+    class Private;
+    Private *const d;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(BlueDevil::RSSISample, Q_PRIMITIVE_TYPE);
+
+#endif // BLUEDEVILRSSIHISTORY_H
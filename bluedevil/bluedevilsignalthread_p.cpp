@@ -0,0 +1,215 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevilsignalthread_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEventLoop>
+#include <QtDBus/QDBusConnection>
+
+namespace BlueDevil {
+
+// Past this a batch is posted without waiting for the bus to go quiet
+static const int maximumBatchSize = 512;
+
+SignalBatchEvent::SignalBatchEvent(int signalCount, const QList<TraceEvent> &events)
+    : QEvent(eventType())
+    , signalCount(signalCount)
+    , events(events)
+{
+}
+
+QEvent::Type SignalBatchEvent::eventType()
+{
+    static const QEvent::Type type = QEvent::Type(QEvent::registerEventType());
+    return type;
+}
+
+SignalReceiver::SignalReceiver(QObject *consumer)
+    : m_consumer(consumer)
+    , m_signalCount(0)
+{
+    // Signals already read from the socket are delivered before the timer fires
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(0);
+    connect(&m_flushTimer, SIGNAL(timeout()), SLOT(_k_flush()));
+}
+
+void SignalReceiver::_k_interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces)
+{
+    TraceEvent event;
+    event.type = TraceEvent::InterfacesAdded;
+    event.timestamp = 0;
+    event.path = objectPath.path();
+    event.interfaces = interfaces;
+
+    // Changes from before are not merged with the ones from after
+    forgetProperties(event.path);
+    append(event);
+}
+
+void SignalReceiver::_k_interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces)
+{
+    TraceEvent event;
+    event.type = TraceEvent::InterfacesRemoved;
+    event.timestamp = 0;
+    event.path = objectPath.path();
+    event.names = interfaces;
+
+    forgetProperties(event.path);
+    append(event);
+}
+
+void SignalReceiver::_k_propertiesChanged(const QString &interface, const QVariantMap &changed,
+                                          const QStringList &invalidated, const QDBusMessage &message)
+{
+    const QPair<QString, QString> key(message.path(), interface);
+    QHash<QPair<QString, QString>, int>::const_iterator it = m_pendingProperties.constFind(key);
+    // Every RSSI reading is a sample of the device's RSSIHistory, so none of them is merged away
+    if (it == m_pendingProperties.constEnd() || changed.contains("RSSI")) {
+        TraceEvent event;
+        event.type = TraceEvent::PropertiesChanged;
+        event.timestamp = 0;
+        event.path = message.path();
+        event.interface = interface;
+        event.properties = changed;
+        event.names = invalidated;
+
+        m_pendingProperties.insert(key, m_events.count());
+        append(event);
+        return;
+    }
+
+    // The latest value of each property wins, and a property is either changed or invalidated
+    TraceEvent &event = m_events[it.value()];
+    QVariantMap::const_iterator changedIt;
+    for (changedIt = changed.constBegin(); changedIt != changed.constEnd(); ++changedIt) {
+        event.properties.insert(changedIt.key(), changedIt.value());
+        event.names.removeAll(changedIt.key());
+    }
+    Q_FOREACH (const QString &name, invalidated) {
+        event.properties.remove(name);
+        if (!event.names.contains(name)) {
+            event.names.append(name);
+        }
+    }
+    ++m_signalCount;
+}
+
+void SignalReceiver::_k_flush()
+{
+    m_flushTimer.stop();
+    if (m_events.isEmpty()) {
+        return;
+    }
+
+    QCoreApplication::postEvent(m_consumer, new SignalBatchEvent(m_signalCount, m_events));
+    m_events.clear();
+    m_pendingProperties.clear();
+    m_signalCount = 0;
+}
+
+void SignalReceiver::append(const TraceEvent &event)
+{
+    m_events.append(event);
+    ++m_signalCount;
+
+    if (m_events.count() >= maximumBatchSize) {
+        _k_flush();
+    } else if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void SignalReceiver::forgetProperties(const QString &path)
+{
+    QHash<QPair<QString, QString>, int>::iterator it = m_pendingProperties.begin();
+    while (it != m_pendingProperties.end()) {
+        if (it.key().first == path) {
+            it = m_pendingProperties.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+SignalThread::SignalThread(QObject *consumer)
+    : m_consumer(consumer)
+    , m_connectionName(QString("BlueDevil-signals-%1").arg(quintptr(this), 0, 16))
+    , m_connected(false)
+    , m_loop(0)
+{
+    // Registered here so that the thread does not race the consumer for it
+    SignalBatchEvent::eventType();
+}
+
+SignalThread::~SignalThread()
+{
+    {
+        // Posted rather than quit(), which is lost if the loop has not started yet
+        QMutexLocker locker(&m_loopMutex);
+        if (m_loop) {
+            QMetaObject::invokeMethod(m_loop, "quit", Qt::QueuedConnection);
+        }
+    }
+    wait();
+}
+
+bool SignalThread::startAndWait()
+{
+    start();
+    m_started.acquire();
+    return m_connected;
+}
+
+void SignalThread::run()
+{
+    {
+        QDBusConnection connection = QDBusConnection::connectToBus(QDBusConnection::SystemBus, m_connectionName);
+        SignalReceiver receiver(m_consumer);
+
+        m_connected = connection.isConnected()
+            && connection.connect("org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded",
+                                  &receiver, SLOT(_k_interfacesAdded(QDBusObjectPath,QVariantMapMap)))
+            && connection.connect("org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved",
+                                  &receiver, SLOT(_k_interfacesRemoved(QDBusObjectPath,QStringList)))
+            && connection.connect("org.bluez", QString(), "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                  &receiver, SLOT(_k_propertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
+
+        QEventLoop loop;
+        {
+            QMutexLocker locker(&m_loopMutex);
+            m_loop = &loop;
+        }
+        m_started.release();
+
+        if (m_connected) {
+            loop.exec();
+        }
+
+        QMutexLocker locker(&m_loopMutex);
+        m_loop = 0;
+    }
+
+    QDBusConnection::disconnectFromBus(m_connectionName);
+}
+
+}
+
+#include "bluedevilsignalthread_p.moc"
@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILSIGNALTHREAD_P_H
+#define BLUEDEVILSIGNALTHREAD_P_H
+
+#include "bluedeviltrace_p.h"
+
+#include <QtCore/QEvent>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusObjectPath>
+
+class QEventLoop;
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ *
+ * The changes decoded from a run of signals, as posted by a SignalThread to its consumer.
+ */
+class SignalBatchEvent
+    : public QEvent
+{
+public:
+    SignalBatchEvent(int signalCount, const QList<TraceEvent> &events);
+
+    static QEvent::Type eventType();
+
+    int               signalCount; // before property changes were merged
+    QList<TraceEvent> events;
+};
+
+/**
+ * @internal
+ *
+ * Lives in a SignalThread and turns the signals from BlueZ into batches of changes. Property
+ * changes of an object that is already in the batch are merged into its pending change, so a
+ * burst of them costs the consumer a single update. RSSI readings are never merged.
+ */
+class SignalReceiver
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    SignalReceiver(QObject *consumer);
+
+public Q_SLOTS:
+    void _k_interfacesAdded(const QDBusObjectPath &objectPath, const QVariantMapMap &interfaces);
+    void _k_interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void _k_propertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated,
+                              const QDBusMessage &message);
+    void _k_flush();
+
+private:
+    void append(const TraceEvent &event);
+    void forgetProperties(const QString &path);
+
+    QObject                               *m_consumer;
+    QTimer                                 m_flushTimer;
+    QList<TraceEvent>                      m_events;
+    int                                    m_signalCount;
+    QHash<QPair<QString, QString>, int>    m_pendingProperties; // path and interface to index in m_events
+};
+
+/**
+ * @internal
+ *
+ * Listens to BlueZ on a connection of its own to the system bus, so that demarshalling the
+ * signals does not happen in the thread of the consumer. The changes are posted to the consumer
+ * as SignalBatchEvent.
+ */
+class SignalThread
+    : public QThread
+{
+public:
+    SignalThread(QObject *consumer);
+    virtual ~SignalThread();
+
+    /**
+     * Starts the thread and waits until it listens to BlueZ.
+     *
+     * @return Whether it could connect to the bus. The thread has finished if not.
+     */
+    bool startAndWait();
+
+protected:
+    virtual void run();
+
+private:
+    QObject    *m_consumer;
+    QString     m_connectionName;
+    QSemaphore  m_started;
+    bool        m_connected;
+    QMutex      m_loopMutex;
+    QEventLoop *m_loop; // while run() has it, whether or not it is running yet
+};
+
+}
+
+#endif // BLUEDEVILSIGNALTHREAD_P_H
@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevilsnapshot_p.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+
+namespace BlueDevil {
+
+static const quint32 snapshotMagic = 0x42445350; // "BDSP"
+static const quint32 snapshotVersion = 2;
+
+// A property name with the type of its value. The file lists each of them once, and then
+// refers to them by index, so values are written bare, without a QVariant header.
+typedef QPair<QString, int> PropertyKey;
+
+/**
+ * @internal
+ */
+static void collectKeys(const QMap<QString, QVariantMap> &objects, QHash<PropertyKey, quint32> *keys,
+                        QList<PropertyKey> *keyList)
+{
+    QMap<QString, QVariantMap>::const_iterator objectIt;
+    for (objectIt = objects.constBegin(); objectIt != objects.constEnd(); ++objectIt) {
+        QVariantMap::const_iterator it;
+        for (it = objectIt.value().constBegin(); it != objectIt.value().constEnd(); ++it) {
+            const PropertyKey key(it.key(), it.value().userType());
+            // Only the basic types can be saved without a registered stream operator
+            if (key.second == QVariant::Invalid || key.second >= QMetaType::User || keys->contains(key)) {
+                continue;
+            }
+            QByteArray scratch;
+            QDataStream scratchStream(&scratch, QIODevice::WriteOnly);
+            if (!QMetaType::save(scratchStream, key.second, it.value().constData())) {
+                // Pointers, or a type of QtGui
+                continue;
+            }
+            keys->insert(key, keyList->count());
+            keyList->append(key);
+        }
+    }
+}
+
+/**
+ * @internal
+ */
+static void writeObjects(QDataStream &stream, const QMap<QString, QVariantMap> &objects,
+                         const QHash<PropertyKey, quint32> &keys)
+{
+    stream << quint32(objects.count());
+    QMap<QString, QVariantMap>::const_iterator objectIt;
+    for (objectIt = objects.constBegin(); objectIt != objects.constEnd(); ++objectIt) {
+        QList<QPair<quint32, QVariant> > properties;
+        QVariantMap::const_iterator it;
+        for (it = objectIt.value().constBegin(); it != objectIt.value().constEnd(); ++it) {
+            const QHash<PropertyKey, quint32>::const_iterator keyIt = keys.constFind(PropertyKey(it.key(), it.value().userType()));
+            if (keyIt != keys.constEnd()) {
+                properties << qMakePair(keyIt.value(), it.value());
+            }
+        }
+
+        stream << objectIt.key() << quint32(properties.count());
+        for (int i = 0; i < properties.count(); ++i) {
+            const QVariant &value = properties.at(i).second;
+            stream << properties.at(i).first;
+            QMetaType::save(stream, value.userType(), value.constData());
+        }
+    }
+}
+
+/**
+ * @internal
+ */
+static bool readObjects(QDataStream &stream, const QList<PropertyKey> &keys, QMap<QString, QVariantMap> *objects)
+{
+    quint32 objectCount;
+    stream >> objectCount;
+    for (quint32 object = 0; object < objectCount && stream.status() == QDataStream::Ok; ++object) {
+        QString path;
+        quint32 propertyCount;
+        stream >> path >> propertyCount;
+
+        QVariantMap properties;
+        for (quint32 property = 0; property < propertyCount && stream.status() == QDataStream::Ok; ++property) {
+            quint32 index;
+            stream >> index;
+            if (index >= quint32(keys.count())) {
+                return false;
+            }
+            const PropertyKey &key = keys.at(index);
+            QVariant value(key.second, static_cast<const void*>(0));
+            if (!QMetaType::load(stream, key.second, value.data())) {
+                return false;
+            }
+            properties.insert(key.first, value);
+        }
+        objects->insert(path, properties);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+bool readSnapshot(const QString &fileName, Snapshot *snapshot)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // The strings are copied out while parsing, so the mapping is not needed afterwards
+    QByteArray data;
+    const uchar *const mapped = file.map(0, file.size());
+    if (mapped) {
+        data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(file.size()));
+    } else {
+        data = file.readAll();
+    }
+
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if (magic != snapshotMagic || version != snapshotVersion) {
+        return false;
+    }
+
+    quint32 keyCount;
+    stream >> keyCount;
+    QList<PropertyKey> keys;
+    for (quint32 i = 0; i < keyCount && stream.status() == QDataStream::Ok; ++i) {
+        PropertyKey key;
+        qint32 type;
+        stream >> key.first >> type;
+        if (type == QVariant::Invalid || type >= QMetaType::User) {
+            return false;
+        }
+        key.second = type;
+        keys << key;
+    }
+
+    Snapshot read;
+    if (stream.status() != QDataStream::Ok || !readObjects(stream, keys, &read.adapters)
+        || !readObjects(stream, keys, &read.devices)) {
+        return false;
+    }
+
+    *snapshot = read;
+    return true;
+}
+
+bool writeSnapshot(const QString &fileName, const Snapshot &snapshot)
+{
+    const QFileInfo info(fileName);
+    if (!QDir().mkpath(info.absolutePath())) {
+        return false;
+    }
+
+    const QString newFileName = fileName + QLatin1String(".new");
+    QFile file(newFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    QHash<PropertyKey, quint32> keys;
+    QList<PropertyKey> keyList;
+    collectKeys(snapshot.adapters, &keys, &keyList);
+    collectKeys(snapshot.devices, &keys, &keyList);
+
+    stream << snapshotMagic << snapshotVersion << quint32(keyList.count());
+    Q_FOREACH (const PropertyKey &key, keyList) {
+        stream << key.first << qint32(key.second);
+    }
+    writeObjects(stream, snapshot.adapters, keys);
+    writeObjects(stream, snapshot.devices, keys);
+    file.close();
+
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+        QFile::remove(newFileName);
+        return false;
+    }
+
+    // QFile::rename does not overwrite
+    QFile::remove(fileName);
+    return QFile::rename(newFileName, fileName);
+}
+
+/**
+ * @internal
+ *
+ * QVariant::operator== does not compare the value of shorts in Qt 4, and UUIDs are cached in
+ * uppercase while BlueZ reports them in lowercase.
+ */
+static bool sameValue(const QVariant &a, const QVariant &b)
+{
+    switch (a.userType()) {
+    case QVariant::StringList: {
+        if (b.userType() != QVariant::StringList) {
+            return false;
+        }
+        const QStringList aList = a.toStringList();
+        const QStringList bList = b.toStringList();
+        if (aList.count() != bList.count()) {
+            return false;
+        }
+        for (int i = 0; i < aList.count(); ++i) {
+            if (aList.at(i).compare(bList.at(i), Qt::CaseInsensitive) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case QMetaType::Short:
+        return b.userType() == QMetaType::Short && a.value<short>() == b.value<short>();
+    case QMetaType::UShort:
+        return b.userType() == QMetaType::UShort && a.value<ushort>() == b.value<ushort>();
+    default:
+        return a == b;
+    }
+}
+
+static bool isEmptyValue(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QVariant::String:
+        return value.toString().isEmpty();
+    case QVariant::StringList:
+        return value.toStringList().isEmpty();
+    case QVariant::Bool:
+        return !value.toBool();
+    case QMetaType::Short:
+        return value.value<short>() == 0;
+    case QMetaType::UShort:
+        return value.value<ushort>() == 0;
+    default:
+        return value.toUInt() == 0;
+    }
+}
+
+void diffProperties(const QVariantMap &cached, const QVariantMap &live, QVariantMap *changed, QStringList *invalidated)
+{
+    QVariantMap::const_iterator it;
+    for (it = cached.constBegin(); it != cached.constEnd(); ++it) {
+        const QVariantMap::const_iterator liveIt = live.constFind(it.key());
+        if (liveIt == live.constEnd()) {
+            if (!isEmptyValue(it.value())) {
+                invalidated->append(it.key());
+            }
+        } else if (!sameValue(it.value(), liveIt.value())) {
+            changed->insert(it.key(), liveIt.value());
+        }
+    }
+}
+
+}
@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILSNAPSHOT_P_H
+#define BLUEDEVILSNAPSHOT_P_H
+
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ *
+ * The adapters and known devices saved by the Manager, with their cached properties, keyed by
+ * object path. The properties of a device also hold the path of its adapter as "Adapter".
+ */
+struct Snapshot
+{
+    QMap<QString, QVariantMap> adapters;
+    QMap<QString, QVariantMap> devices;
+};
+
+/**
+ * @internal
+ *
+ * Reads @p fileName, which is memory mapped while it is parsed. Property names are stored once
+ * with the type of their values, and the values themselves without a QVariant header.
+ *
+ * @return Whether @p fileName held a valid snapshot.
+ */
+bool readSnapshot(const QString &fileName, Snapshot *snapshot);
+
+/**
+ * @internal
+ *
+ * Replaces @p fileName with @p snapshot. Readers never see a partially written file.
+ */
+bool writeSnapshot(const QString &fileName, const Snapshot &snapshot);
+
+/**
+ * @internal
+ *
+ * Compares the @p cached properties of an object with the @p live ones reported by BlueZ. Only
+ * the properties in @p cached are considered. Those missing from @p live are reported as
+ * invalidated, unless they already hold an empty value.
+ */
+void diffProperties(const QVariantMap &cached, const QVariantMap &live, QVariantMap *changed, QStringList *invalidated);
+
+}
+
+#endif // BLUEDEVILSNAPSHOT_P_H
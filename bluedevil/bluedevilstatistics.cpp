@@ -0,0 +1,218 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedevilstatistics.h"
+#include "bluedevilstatistics_p.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QtAlgorithms>
+
+namespace BlueDevil {
+
+// The bound of the first latency bucket is 1 << firstBucketShift microseconds
+static const int firstBucketShift = 7;
+
+/**
+ * @internal
+ */
+struct CallKey
+{
+    QString              interface;
+    QString              member;
+    CallStatistics::Type type;
+
+    bool operator==(const CallKey &other) const
+    {
+        return type == other.type && member == other.member && interface == other.interface;
+    }
+};
+
+static uint qHash(const CallKey &key)
+{
+    return qHash(key.member) ^ (qHash(key.interface) << 2) ^ uint(key.type);
+}
+
+/**
+ * @internal
+ *
+ * Everything the library does on the bus happens in the thread of the Manager, so there is no
+ * locking.
+ */
+struct StatisticsData
+{
+    StatisticsData()
+        : callsInFlight(0)
+        , signalCount(0)
+        , currentSecond(0)
+        , currentSecondSignals(0)
+        , lastSecondSignals(0)
+    {
+        clock.start();
+    }
+
+    QElapsedTimer                   clock;
+    QHash<CallKey, CallStatistics>  calls;
+    int                             callsInFlight;
+    quint64                         signalCount;
+    qint64                          currentSecond;
+    quint64                         currentSecondSignals;
+    quint64                         lastSecondSignals; // during currentSecond - 1
+};
+
+Q_GLOBAL_STATIC(StatisticsData, statisticsData)
+
+qint64 CallStatistics::latencyBucketBound(int bucket)
+{
+    if (bucket < 0 || bucket >= LatencyBuckets - 1) {
+        return -1;
+    }
+    return Q_INT64_C(1) << (firstBucketShift + bucket);
+}
+
+static int latencyBucket(qint64 latency)
+{
+    int bucket = 0;
+    for (qint64 bound = Q_INT64_C(1) << firstBucketShift; latency >= bound && bucket < CallStatistics::LatencyBuckets - 1;
+         bound <<= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+/**
+ * @internal
+ *
+ * Moves the signal rate forward to @p second.
+ */
+static void advanceSignalRate(StatisticsData *data, qint64 second)
+{
+    if (second == data->currentSecond) {
+        return;
+    }
+    data->lastSecondSignals = second == data->currentSecond + 1 ? data->currentSecondSignals : 0;
+    data->currentSecond = second;
+    data->currentSecondSignals = 0;
+}
+
+qint64 statisticsClock()
+{
+    return statisticsData()->clock.nsecsElapsed() / 1000;
+}
+
+void asyncCallStarted()
+{
+    ++statisticsData()->callsInFlight;
+}
+
+void recordCall(const char *interface, const QString &member, CallStatistics::Type type, bool synchronous,
+                qint64 started, bool failed)
+{
+    StatisticsData *const data = statisticsData();
+    if (!synchronous && data->callsInFlight > 0) {
+        --data->callsInFlight;
+    }
+
+    CallKey key;
+    key.interface = QLatin1String(interface);
+    key.member = member;
+    key.type = type;
+
+    QHash<CallKey, CallStatistics>::iterator it = data->calls.find(key);
+    if (it == data->calls.end()) {
+        CallStatistics statistics;
+        statistics.interface = key.interface;
+        statistics.member = key.member;
+        statistics.type = type;
+        statistics.count = 0;
+        statistics.synchronousCount = 0;
+        statistics.errorCount = 0;
+        statistics.totalLatency = 0;
+        statistics.maxLatency = 0;
+        qFill(statistics.latencyHistogram, statistics.latencyHistogram + CallStatistics::LatencyBuckets, quint64(0));
+        it = data->calls.insert(key, statistics);
+    }
+
+    const qint64 latency = qMax(qint64(0), data->clock.nsecsElapsed() / 1000 - started);
+    CallStatistics &statistics = it.value();
+    ++statistics.count;
+    if (synchronous) {
+        ++statistics.synchronousCount;
+    }
+    if (failed) {
+        ++statistics.errorCount;
+    }
+    statistics.totalLatency += latency;
+    statistics.maxLatency = qMax(statistics.maxLatency, latency);
+    ++statistics.latencyHistogram[latencyBucket(latency)];
+}
+
+void recordSignal(int count)
+{
+    StatisticsData *const data = statisticsData();
+    advanceSignalRate(data, data->clock.elapsed() / 1000);
+    data->currentSecondSignals += count;
+    data->signalCount += count;
+}
+
+BusStatistics busStatistics()
+{
+    StatisticsData *const data = statisticsData();
+    advanceSignalRate(data, data->clock.elapsed() / 1000);
+
+    BusStatistics statistics;
+    statistics.calls = data->calls.values();
+    statistics.callsInFlight = data->callsInFlight;
+    statistics.signalCount = data->signalCount;
+    statistics.signalsPerSecond = data->lastSecondSignals;
+    return statistics;
+}
+
+void resetBusStatistics()
+{
+    // Calls in flight are still in flight
+    StatisticsData *const data = statisticsData();
+    data->calls.clear();
+    data->signalCount = 0;
+    data->currentSecondSignals = 0;
+    data->lastSecondSignals = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SynchronousCall::SynchronousCall(const char *interface, const char *member, CallStatistics::Type type)
+    : m_interface(interface)
+    , m_member(member)
+    , m_type(type)
+    , m_started(statisticsClock())
+    , m_failed(false)
+{
+}
+
+SynchronousCall::~SynchronousCall()
+{
+    recordCall(m_interface, QLatin1String(m_member), m_type, true, m_started, m_failed);
+}
+
+void SynchronousCall::setFailed(bool failed)
+{
+    m_failed = failed;
+}
+
+}
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILSTATISTICS_H
+#define BLUEDEVILSTATISTICS_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+namespace BlueDevil {
+
+/**
+ * How often a property or method of a BlueZ interface was called on the bus, and how long the
+ * replies took.
+ *
+ * @see Manager::busStatistics
+ */
+struct BLUEDEVIL_EXPORT CallStatistics
+{
+    enum Type {
+        GetCall = 0, ///< A property was read
+        SetCall,     ///< A property was written
+        MethodCall   ///< A method was called
+    };
+
+    enum {
+        LatencyBuckets = 16
+    };
+
+    /**
+     * @return The exclusive upper bound, in microseconds, of the latencies counted in @p bucket of
+     *         latencyHistogram. Bucket 0 counts replies faster than 128 microseconds, and each
+     *         bucket doubles the bound of the previous one. The last bucket has no upper bound,
+     *         and -1 is returned for it.
+     */
+    static qint64 latencyBucketBound(int bucket);
+
+    /**
+     * The D-Bus interface, as in "org.bluez.Device1".
+     */
+    QString interface;
+
+    /**
+     * The property or method name.
+     */
+    QString member;
+
+    Type type;
+
+    /**
+     * The number of calls that have been answered, including failed ones. Calls still waiting
+     * for a reply are not counted yet.
+     */
+    quint64 count;
+
+    /**
+     * How many of them blocked the caller until the reply arrived.
+     */
+    quint64 synchronousCount;
+
+    /**
+     * How many of them failed.
+     */
+    quint64 errorCount;
+
+    /**
+     * The sum of their latencies, in microseconds.
+     */
+    qint64 totalLatency;
+
+    /**
+     * The longest latency, in microseconds.
+     */
+    qint64 maxLatency;
+
+    /**
+     * How many calls fell in each latency range. See latencyBucketBound.
+     */
+    quint64 latencyHistogram[LatencyBuckets];
+};
+
+/**
+ * The traffic between BlueDevil and BlueZ since the application started, or since
+ * Manager::resetBusStatistics was called.
+ *
+ * @see Manager::busStatistics
+ */
+struct BLUEDEVIL_EXPORT BusStatistics
+{
+    /**
+     * One entry for each property or method that was called, and each kind of call.
+     */
+    QList<CallStatistics> calls;
+
+    /**
+     * The number of asynchronous calls that are still waiting for a reply.
+     */
+    int callsInFlight;
+
+    /**
+     * The number of signals received from BlueZ about adapters and devices being added, removed
+     * or changed.
+     */
+    quint64 signalCount;
+
+    /**
+     * The number of those signals received during the last whole second.
+     */
+    quint64 signalsPerSecond;
+};
+
+}
+
+#endif // BLUEDEVILSTATISTICS_H
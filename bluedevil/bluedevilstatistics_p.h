@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILSTATISTICS_P_H
+#define BLUEDEVILSTATISTICS_P_H
+
+#include "bluedevilstatistics.h"
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ *
+ * @return Microseconds on a monotonic clock, to be passed to recordCall as the time the call was
+ *         sent.
+ */
+qint64 statisticsClock();
+
+/**
+ * @internal
+ *
+ * Counts an asynchronous call as in flight until recordCall is called for it.
+ */
+void asyncCallStarted();
+
+/**
+ * @internal
+ *
+ * Records a call to @p member of @p interface that was sent at @p started, as given by
+ * statisticsClock, and has just been answered.
+ */
+void recordCall(const char *interface, const QString &member, CallStatistics::Type type, bool synchronous,
+                qint64 started, bool failed);
+
+/**
+ * @internal
+ */
+void recordSignal(int count = 1);
+
+/**
+ * @internal
+ */
+BusStatistics busStatistics();
+
+/**
+ * @internal
+ */
+void resetBusStatistics();
+
+/**
+ * @internal
+ *
+ * Times a blocking call for as long as it is in scope.
+ *
+ * @code
+ * SynchronousCall call("org.bluez.Adapter1", "Powered", CallStatistics::SetCall);
+ * interface->setPowered(powered);
+ * call.setFailed(interface->lastError().isValid());
+ * @endcode
+ */
+class SynchronousCall
+{
+public:
+    SynchronousCall(const char *interface, const char *member, CallStatistics::Type type);
+    ~SynchronousCall();
+
+    void setFailed(bool failed);
+
+private:
+    const char          *m_interface;
+    const char          *m_member;
+    CallStatistics::Type m_type;
+    qint64               m_started;
+    bool                 m_failed;
+};
+
+}
+
+#endif // BLUEDEVILSTATISTICS_P_H
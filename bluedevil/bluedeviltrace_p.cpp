@@ -0,0 +1,366 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedeviltrace_p.h"
+
+#include <QtDBus/QDBusObjectPath>
+
+namespace BlueDevil {
+
+static const quint32 traceMagic = 0x42445452; // "BDTR"
+static const quint32 traceVersion = 2;
+
+TraceWriter::TraceWriter()
+    : m_lastTimestamp(0)
+{
+}
+
+bool TraceWriter::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_4_6);
+    m_stream << traceMagic << traceVersion;
+
+    m_strings.clear();
+    m_keys.clear();
+    m_lastTimestamp = 0;
+    m_clock.start();
+    return m_stream.status() == QDataStream::Ok;
+}
+
+void TraceWriter::close()
+{
+    m_stream.setDevice(0);
+    m_file.close();
+}
+
+QString TraceWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+void TraceWriter::interfacesAdded(const QString &path, const QVariantMapMap &interfaces)
+{
+    writeHeader(TraceEvent::InterfacesAdded, path);
+    m_stream << quint32(interfaces.count());
+    QVariantMapMap::const_iterator it;
+    for (it = interfaces.constBegin(); it != interfaces.constEnd(); ++it) {
+        writeString(it.key());
+        writeProperties(it.value());
+    }
+}
+
+void TraceWriter::interfacesRemoved(const QString &path, const QStringList &interfaces)
+{
+    writeHeader(TraceEvent::InterfacesRemoved, path);
+    writeStrings(interfaces);
+}
+
+void TraceWriter::propertiesChanged(const QString &path, const QString &interface, const QVariantMap &changed,
+                                    const QStringList &invalidated)
+{
+    writeHeader(TraceEvent::PropertiesChanged, path);
+    writeString(interface);
+    writeProperties(changed);
+    writeStrings(invalidated);
+}
+
+void TraceWriter::writeEvent(const TraceEvent &event)
+{
+    switch (event.type) {
+    case TraceEvent::InterfacesAdded:
+        interfacesAdded(event.path, event.interfaces);
+        break;
+    case TraceEvent::InterfacesRemoved:
+        interfacesRemoved(event.path, event.names);
+        break;
+    case TraceEvent::PropertiesChanged:
+        propertiesChanged(event.path, event.interface, event.properties, event.names);
+        break;
+    }
+}
+
+void TraceWriter::flush()
+{
+    m_file.flush();
+}
+
+void TraceWriter::writeHeader(TraceEvent::Type type, const QString &path)
+{
+    const qint64 timestamp = m_clock.elapsed();
+    m_stream << quint8(type) << quint32(timestamp - m_lastTimestamp);
+    m_lastTimestamp = timestamp;
+    writeString(path);
+}
+
+void TraceWriter::writeString(const QString &string)
+{
+    QHash<QString, quint32>::const_iterator it = m_strings.constFind(string);
+    if (it != m_strings.constEnd()) {
+        m_stream << it.value();
+        return;
+    }
+
+    // An index one past the known strings introduces a new one
+    const quint32 index = m_strings.count();
+    m_strings.insert(string, index);
+    m_stream << index << string;
+}
+
+void TraceWriter::writeStrings(const QStringList &strings)
+{
+    m_stream << quint32(strings.count());
+    Q_FOREACH (const QString &string, strings) {
+        writeString(string);
+    }
+}
+
+void TraceWriter::writeProperties(const QVariantMap &properties)
+{
+    // What can be saved is known before the count is written
+    QList<QPair<QString, QVariant> > savable;
+    QVariantMap::const_iterator it;
+    for (it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        if (it.value().userType() == qMetaTypeId<QDBusObjectPath>()) {
+            savable << qMakePair(it.key(), QVariant(it.value().value<QDBusObjectPath>().path()));
+        } else if (isSavable(it.value().userType())) {
+            savable << qMakePair(it.key(), it.value());
+        }
+    }
+
+    m_stream << quint32(savable.count());
+    QList<QPair<QString, QVariant> >::const_iterator savableIt;
+    for (savableIt = savable.constBegin(); savableIt != savable.constEnd(); ++savableIt) {
+        const QVariant &value = savableIt->second;
+        const PropertyKey key(savableIt->first, value.userType());
+        QHash<PropertyKey, quint32>::const_iterator keyIt = m_keys.constFind(key);
+        if (keyIt != m_keys.constEnd()) {
+            m_stream << keyIt.value();
+        } else {
+            // As with strings, an index one past the known keys introduces a new one
+            const quint32 index = m_keys.count();
+            m_keys.insert(key, index);
+            m_stream << index;
+            writeString(key.first);
+            m_stream << qint32(key.second);
+        }
+        QMetaType::save(m_stream, key.second, value.constData());
+    }
+}
+
+bool TraceWriter::isSavable(int type)
+{
+    // Only the basic types can be saved without a registered stream operator
+    if (type == QVariant::Invalid || type >= QMetaType::User) {
+        return false;
+    }
+
+    QHash<int, bool>::const_iterator it = m_savableTypes.constFind(type);
+    if (it != m_savableTypes.constEnd()) {
+        return it.value();
+    }
+
+    // Pointers, or a type of QtGui
+    QByteArray scratch;
+    QDataStream scratchStream(&scratch, QIODevice::WriteOnly);
+    scratchStream.setVersion(QDataStream::Qt_4_6);
+    const QVariant value(type, static_cast<const void*>(0));
+    const bool savable = QMetaType::save(scratchStream, type, value.constData());
+    m_savableTypes.insert(type, savable);
+    return savable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TraceReader::TraceReader()
+    : m_timestamp(0)
+{
+}
+
+bool TraceReader::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const uchar *const mapped = m_file.map(0, m_file.size());
+    if (mapped) {
+        m_buffer.setData(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(m_file.size())));
+    } else {
+        m_buffer.setData(m_file.readAll());
+    }
+    m_buffer.open(QIODevice::ReadOnly);
+
+    m_stream.setDevice(&m_buffer);
+    m_stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic;
+    quint32 version;
+    m_stream >> magic >> version;
+    if (m_stream.status() != QDataStream::Ok || magic != traceMagic || version != traceVersion) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TraceReader::close()
+{
+    m_stream.setDevice(0);
+    m_buffer.close();
+    m_buffer.setData(QByteArray());
+    m_file.close();
+    m_timestamp = 0;
+    m_strings.clear();
+    m_keys.clear();
+}
+
+bool TraceReader::readEvent(TraceEvent *event)
+{
+    if (!m_stream.device() || m_stream.atEnd()) {
+        return false;
+    }
+
+    quint8 type;
+    quint32 delta;
+    m_stream >> type >> delta;
+    if (!readString(&event->path)) {
+        return false;
+    }
+    m_timestamp += delta;
+    event->timestamp = m_timestamp;
+    event->type = TraceEvent::Type(type);
+    event->interfaces.clear();
+    event->interface.clear();
+    event->properties.clear();
+    event->names.clear();
+
+    quint32 count;
+    switch (type) {
+    case TraceEvent::InterfacesAdded:
+        m_stream >> count;
+        for (quint32 i = 0; i < count && m_stream.status() == QDataStream::Ok; ++i) {
+            QString interface;
+            if (!readString(&interface)) {
+                return false;
+            }
+            QVariantMap properties;
+            if (!readProperties(&properties)) {
+                return false;
+            }
+            // Devices are matched to their adapter through this one
+            if (interface == QLatin1String("org.bluez.Device1") && properties.contains("Adapter")) {
+                properties.insert("Adapter", QVariant::fromValue(QDBusObjectPath(properties.value("Adapter").toString())));
+            }
+            event->interfaces.insert(interface, properties);
+        }
+        break;
+    case TraceEvent::InterfacesRemoved:
+        if (!readStrings(&event->names)) {
+            return false;
+        }
+        break;
+    case TraceEvent::PropertiesChanged:
+        if (!readString(&event->interface) || !readProperties(&event->properties)
+            || !readStrings(&event->names)) {
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    return m_stream.status() == QDataStream::Ok;
+}
+
+bool TraceReader::readString(QString *string)
+{
+    quint32 index;
+    m_stream >> index;
+    if (m_stream.status() != QDataStream::Ok || index > quint32(m_strings.count())) {
+        return false;
+    }
+
+    if (index == quint32(m_strings.count())) {
+        m_stream >> *string;
+        m_strings.append(*string);
+    } else {
+        *string = m_strings.at(index);
+    }
+    return m_stream.status() == QDataStream::Ok;
+}
+
+bool TraceReader::readStrings(QStringList *strings)
+{
+    quint32 count;
+    m_stream >> count;
+    for (quint32 i = 0; i < count && m_stream.status() == QDataStream::Ok; ++i) {
+        QString string;
+        if (!readString(&string)) {
+            return false;
+        }
+        strings->append(string);
+    }
+    return m_stream.status() == QDataStream::Ok;
+}
+
+bool TraceReader::readProperties(QVariantMap *properties)
+{
+    quint32 count;
+    m_stream >> count;
+    for (quint32 i = 0; i < count && m_stream.status() == QDataStream::Ok; ++i) {
+        quint32 index;
+        m_stream >> index;
+        if (m_stream.status() != QDataStream::Ok || index > quint32(m_keys.count())) {
+            return false;
+        }
+
+        if (index == quint32(m_keys.count())) {
+            PropertyKey key;
+            qint32 type;
+            if (!readString(&key.first)) {
+                return false;
+            }
+            m_stream >> type;
+            if (type == QVariant::Invalid || type >= QMetaType::User) {
+                return false;
+            }
+            key.second = type;
+            m_keys.append(key);
+        }
+
+        const PropertyKey &key = m_keys.at(index);
+        QVariant value(key.second, static_cast<const void*>(0));
+        if (!QMetaType::load(m_stream, key.second, value.data())) {
+            return false;
+        }
+        properties->insert(key.first, value);
+    }
+    return m_stream.status() == QDataStream::Ok;
+}
+
+}
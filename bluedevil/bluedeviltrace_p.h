@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILTRACE_P_H
+#define BLUEDEVILTRACE_P_H
+
+#include "bluedevildbustypes.h"
+
+#include <QtCore/QBuffer>
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ *
+ * One of the signals from BlueZ that the Manager reacts to.
+ */
+struct TraceEvent
+{
+    enum Type {
+        InterfacesAdded = 1,
+        InterfacesRemoved,
+        PropertiesChanged
+    };
+
+    Type           type;
+    qint64         timestamp;  // milliseconds since the recording started
+    QString        path;
+    QVariantMapMap interfaces; // InterfacesAdded
+    QString        interface;  // PropertiesChanged
+    QVariantMap    properties; // PropertiesChanged, the changed properties
+    QStringList    names;      // the removed interfaces, or the invalidated properties
+};
+
+/**
+ * @internal
+ *
+ * Appends events to a trace file as they happen. Object paths, interface names and property
+ * names with their type are written once and then referred to by index, as the same few of them
+ * are in nearly every event, and property values are written without a type of their own.
+ *
+ * Property values that are not basic types, like dictionaries still wrapped in a QDBusArgument,
+ * are left out. Object paths are kept as strings.
+ */
+class TraceWriter
+{
+public:
+    TraceWriter();
+
+    bool open(const QString &fileName);
+    void close();
+    QString fileName() const;
+
+    void interfacesAdded(const QString &path, const QVariantMapMap &interfaces);
+    void interfacesRemoved(const QString &path, const QStringList &interfaces);
+    void propertiesChanged(const QString &path, const QString &interface, const QVariantMap &changed,
+                           const QStringList &invalidated);
+    void writeEvent(const TraceEvent &event);
+
+    /**
+     * Writes out what is still buffered, so that the trace is complete up to here if the
+     * process does not get to close it.
+     */
+    void flush();
+
+private:
+    typedef QPair<QString, int> PropertyKey;
+
+    void writeHeader(TraceEvent::Type type, const QString &path);
+    void writeString(const QString &string);
+    void writeStrings(const QStringList &strings);
+    void writeProperties(const QVariantMap &properties);
+    bool isSavable(int type);
+
+    QFile                       m_file;
+    QDataStream                 m_stream;
+    QElapsedTimer               m_clock;
+    qint64                      m_lastTimestamp;
+    QHash<QString, quint32>     m_strings;
+    QHash<PropertyKey, quint32> m_keys;
+    QHash<int, bool>            m_savableTypes;
+};
+
+/**
+ * @internal
+ *
+ * Reads the events of a trace file one by one. The file is memory mapped, so replaying a long
+ * trace does not keep it all in memory as parsed events.
+ */
+class TraceReader
+{
+public:
+    TraceReader();
+
+    bool open(const QString &fileName);
+    void close();
+
+    /**
+     * @return Whether there was another event. It is false at the end of the trace, or if the
+     *         rest of the file is not valid.
+     */
+    bool readEvent(TraceEvent *event);
+
+private:
+    typedef QPair<QString, int> PropertyKey;
+
+    bool readString(QString *string);
+    bool readStrings(QStringList *strings);
+    bool readProperties(QVariantMap *properties);
+
+    QFile              m_file;
+    QBuffer            m_buffer;
+    QDataStream        m_stream;
+    qint64             m_timestamp;
+    QStringList        m_strings;
+    QList<PropertyKey> m_keys;
+};
+
+}
+
+#endif // BLUEDEVILTRACE_P_H
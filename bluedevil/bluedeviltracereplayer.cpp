@@ -0,0 +1,187 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "bluedeviltracereplayer.h"
+#include "bluedevilmanager.h"
+#include "bluedevilmanager_p.h"
+#include "bluedeviltrace_p.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
+
+namespace BlueDevil {
+
+// At maximum speed, events replayed before returning to the event loop
+static const int maximumSpeedBatch = 256;
+
+/**
+ * @internal
+ */
+class TraceReplayer::Private
+{
+public:
+    Private(TraceReplayer *q);
+
+    void restartClock();
+    void scheduleNext();
+    void _k_replayDue();
+
+    TraceReader              m_reader;
+    TraceEvent               m_next;
+    bool                     m_hasNext;
+    Speed                    m_speed;
+    int                      m_position;
+    bool                     m_running;
+    QPointer<ManagerPrivate> m_manager;
+    QTimer                   m_timer;
+    QElapsedTimer            m_clock;
+    qint64                   m_clockOffset; // trace time at which m_clock was started
+
+    TraceReplayer *const m_q;
+};
+
+TraceReplayer::Private::Private(TraceReplayer *q)
+    : m_hasNext(false)
+    , m_speed(RecordedSpeed)
+    , m_position(0)
+    , m_running(false)
+    , m_clockOffset(0)
+    , m_q(q)
+{
+    m_timer.setSingleShot(true);
+}
+
+void TraceReplayer::Private::restartClock()
+{
+    m_clock.start();
+    m_clockOffset = m_next.timestamp;
+}
+
+void TraceReplayer::Private::scheduleNext()
+{
+    if (m_speed == MaximumSpeed) {
+        m_timer.start(0);
+        return;
+    }
+    m_timer.start(int(qMax(qint64(0), m_next.timestamp - m_clockOffset - m_clock.elapsed())));
+}
+
+void TraceReplayer::Private::_k_replayDue()
+{
+    if (!m_manager) {
+        // The Manager was released while replaying
+        m_running = false;
+        return;
+    }
+
+    int replayed = 0;
+    while (m_running && m_hasNext) {
+        if (m_speed == MaximumSpeed ? replayed == maximumSpeedBatch
+                                    : m_next.timestamp - m_clockOffset > m_clock.elapsed()) {
+            break;
+        }
+        m_manager->processEvent(m_next);
+        ++m_position;
+        ++replayed;
+        m_hasNext = m_reader.readEvent(&m_next);
+    }
+
+    if (!m_hasNext) {
+        m_running = false;
+        emit m_q->finished();
+    } else if (m_running) {
+        scheduleNext();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TraceReplayer::TraceReplayer(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+    connect(&d->m_timer, SIGNAL(timeout()), this, SLOT(_k_replayDue()));
+}
+
+TraceReplayer::~TraceReplayer()
+{
+    delete d;
+}
+
+bool TraceReplayer::load(const QString &fileName)
+{
+    stop();
+    d->m_position = 0;
+    d->m_hasNext = d->m_reader.open(fileName) && d->m_reader.readEvent(&d->m_next);
+    return d->m_hasNext;
+}
+
+TraceReplayer::Speed TraceReplayer::speed() const
+{
+    return d->m_speed;
+}
+
+void TraceReplayer::setSpeed(Speed speed)
+{
+    if (d->m_speed == speed) {
+        return;
+    }
+
+    d->m_speed = speed;
+    if (d->m_running) {
+        // Recorded delays are kept from here on, not from where the replay started
+        d->restartClock();
+        d->scheduleNext();
+    }
+}
+
+int TraceReplayer::position() const
+{
+    return d->m_position;
+}
+
+bool TraceReplayer::isRunning() const
+{
+    return d->m_running;
+}
+
+void TraceReplayer::start()
+{
+    if (d->m_running || !d->m_hasNext) {
+        return;
+    }
+
+    Manager *const manager = Manager::self();
+    manager->d->beginReplay();
+    d->m_manager = manager->d;
+    d->m_running = true;
+    d->restartClock();
+    d->scheduleNext();
+}
+
+void TraceReplayer::stop()
+{
+    d->m_running = false;
+    d->m_timer.stop();
+}
+
+}
+
+#include "bluedeviltracereplayer.moc"
@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILTRACEREPLAYER_H
+#define BLUEDEVILTRACEREPLAYER_H
+
+#include <bluedevil/bluedevil_export.h>
+
+#include <QtCore/QObject>
+
+namespace BlueDevil {
+
+/**
+ * @class TraceReplayer bluedeviltracereplayer.h bluedevil/bluedeviltracereplayer.h
+ *
+ * Feeds a trace written through Manager::startRecording back into the Manager, without BlueZ and
+ * without a bus. Adapters and devices are added, changed and removed as they were when the trace
+ * was recorded, so that the behaviour of the library, and of the application using it, can be
+ * reproduced and profiled offline.
+ *
+ * Starting a replay drops the adapters and devices that the Manager knew of, and the Manager stops
+ * listening to BlueZ until it is released.
+ *
+ * @code
+ * TraceReplayer *replayer = new TraceReplayer(this);
+ * if (replayer->load("scan-storm.trace")) {
+ *     replayer->setSpeed(TraceReplayer::MaximumSpeed);
+ *     replayer->start();
+ * }
+ * @endcode
+ */
+class BLUEDEVIL_EXPORT TraceReplayer
+    : public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(Speed)
+
+    Q_PROPERTY(Speed speed READ speed WRITE setSpeed)
+
+public:
+    enum Speed {
+        RecordedSpeed = 0,
+        MaximumSpeed = 1
+    };
+
+    explicit TraceReplayer(QObject *parent = 0);
+    virtual ~TraceReplayer();
+
+    /**
+     * Opens the trace in @p fileName, and rewinds the replay to its beginning.
+     *
+     * @return Whether @p fileName holds a trace.
+     */
+    bool load(const QString &fileName);
+
+    /**
+     * @return With RecordedSpeed (the default) events are replayed with the delays they were
+     *         recorded with. With MaximumSpeed they are replayed as fast as possible, returning to
+     *         the event loop every few hundred events so that queued signals are still delivered.
+     */
+    Speed speed() const;
+
+    /**
+     * Sets how fast events are replayed. It can be changed while replaying.
+     */
+    void setSpeed(Speed speed);
+
+    /**
+     * @return How many events have been replayed so far.
+     */
+    int position() const;
+
+    /**
+     * @return Whether the replay has been started and has not finished yet.
+     */
+    bool isRunning() const;
+
+public Q_SLOTS:
+    /**
+     * Starts, or resumes, replaying the loaded trace into Manager::self().
+     */
+    void start();
+
+    /**
+     * Pauses the replay. start() resumes it where it was left.
+     */
+    void stop();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the last event of the trace has been replayed.
+     */
+    void finished();
+
+private:
+    class Private;
+    Private *const d;
+
+    Q_PRIVATE_SLOT(d, void _k_replayDue())
+};
+
+}
+
+#endif // BLUEDEVILTRACEREPLAYER_H
@@ -21,6 +21,7 @@
  *****************************************************************************/
 
 #include "bluedevilutils.h"
+#include "bluedevilutils_p.h"
 
 #include <QtCore/QString>
 
@@ -108,4 +109,220 @@ quint32 classToType(quint32 classNum)
     return 0;
 }
 
+quint32 appearanceToType(quint16 appearance)
+{
+    // Categories and subcategories of the GAP Appearance characteristic, which LE devices report
+    // instead of a class
+    switch ((appearance & 0xffc0) >> 6) {
+    case 0x01:
+        return BLUETOOTH_TYPE_PHONE;
+    case 0x02:
+        return BLUETOOTH_TYPE_COMPUTER;
+    case 0x0f:
+        switch (appearance & 0x3f) {
+        case 0x01:
+            return BLUETOOTH_TYPE_KEYBOARD;
+        case 0x02:
+            return BLUETOOTH_TYPE_MOUSE;
+        case 0x03:
+        case 0x04:
+            return BLUETOOTH_TYPE_JOYPAD;
+        case 0x05:
+            return BLUETOOTH_TYPE_TABLET;
+        }
+        break;
+    case 0x21:
+    case 0x22:
+        return BLUETOOTH_TYPE_OTHER_AUDIO;
+    case 0x25:
+        switch (appearance & 0x3f) {
+        case 0x02:
+            return BLUETOOTH_TYPE_HEADSET;
+        case 0x01:
+        case 0x03:
+            return BLUETOOTH_TYPE_HEADPHONES;
+        default:
+            return BLUETOOTH_TYPE_OTHER_AUDIO;
+        }
+        break;
+    }
+
+    return 0;
+}
+
+quint64 addressToKey(const QString &address)
+{
+    quint64 key = 0;
+    const QChar *c = address.constData();
+    const QChar *const end = c + address.size();
+    for (; c != end; ++c) {
+        const ushort u = c->unicode();
+        if (u >= '0' && u <= '9') {
+            key = (key << 4) | (u - '0');
+        } else if (u >= 'A' && u <= 'F') {
+            key = (key << 4) | (u - 'A' + 10);
+        } else if (u >= 'a' && u <= 'f') {
+            key = (key << 4) | (u - 'a' + 10);
+        }
+    }
+    return key;
+}
+
+// 0000xxxx-0000-1000-8000-00805F9B34FB
+static const quint64 baseUUIDHigh = Q_UINT64_C(0x0000000000001000);
+static const quint64 baseUUIDLow  = Q_UINT64_C(0x800000805F9B34FB);
+
+bool packUUID(const QString &UUID, PackedUUID *packed)
+{
+    const QChar *c = UUID.constData();
+    const QChar *const end = c + UUID.size();
+    if (UUID.size() > 2 && c[0] == QLatin1Char('0') && (c[1] == QLatin1Char('x') || c[1] == QLatin1Char('X'))) {
+        c += 2;
+    }
+
+    quint64 high = 0;
+    quint64 low = 0;
+    int digits = 0;
+    for (; c != end; ++c) {
+        const ushort u = c->unicode();
+        quint64 nibble;
+        if (u >= '0' && u <= '9') {
+            nibble = u - '0';
+        } else if (u >= 'A' && u <= 'F') {
+            nibble = u - 'A' + 10;
+        } else if (u >= 'a' && u <= 'f') {
+            nibble = u - 'a' + 10;
+        } else if (u == '-') {
+            continue;
+        } else {
+            return false;
+        }
+        if (++digits > 32) {
+            return false;
+        }
+        high = (high << 4) | (low >> 60);
+        low = (low << 4) | nibble;
+    }
+
+    if (digits == 4 || digits == 8) {
+        packed->high = (low << 32) | baseUUIDHigh;
+        packed->low = baseUUIDLow;
+    } else if (digits == 32) {
+        packed->high = high;
+        packed->low = low;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+quint32 packedUUIDToProfile(const PackedUUID &UUID)
+{
+    if (UUID.low != baseUUIDLow || (UUID.high & 0xffffffff) != baseUUIDHigh) {
+        return 0;
+    }
+
+    switch (UUID.high >> 32) {
+    case 0x110a:
+        return BLUETOOTH_PROFILE_A2DP_SOURCE;
+    case 0x110b:
+        return BLUETOOTH_PROFILE_A2DP_SINK;
+    case 0x110c:
+    case 0x110e:
+    case 0x110f:
+        return BLUETOOTH_PROFILE_AVRCP;
+    case 0x1108:
+    case 0x1131:
+        return BLUETOOTH_PROFILE_HEADSET;
+    case 0x1112:
+        return BLUETOOTH_PROFILE_HEADSET_AG;
+    case 0x111e:
+        return BLUETOOTH_PROFILE_HANDSFREE;
+    case 0x111f:
+        return BLUETOOTH_PROFILE_HANDSFREE_AG;
+    case 0x1124:
+    case 0x1812: // HID over GATT
+        return BLUETOOTH_PROFILE_HID;
+    case 0x1115:
+    case 0x1116:
+    case 0x1117:
+        return BLUETOOTH_PROFILE_PAN;
+    case 0x1105:
+        return BLUETOOTH_PROFILE_OBEX_PUSH;
+    case 0x1106:
+        return BLUETOOTH_PROFILE_OBEX_FTP;
+    case 0x1101:
+        return BLUETOOTH_PROFILE_SERIAL;
+    case 0x1103:
+        return BLUETOOTH_PROFILE_DUN;
+    case 0x112e:
+    case 0x112f:
+        return BLUETOOTH_PROFILE_PBAP;
+    case 0x1132:
+    case 0x1133:
+    case 0x1134:
+        return BLUETOOTH_PROFILE_MAP;
+    }
+
+    return 0;
+}
+
+quint32 UUIDToProfile(const QString &UUID)
+{
+    PackedUUID packed;
+    if (!packUUID(UUID, &packed)) {
+        return 0;
+    }
+    return packedUUIDToProfile(packed);
+}
+
+UUIDSet::UUIDSet()
+    : m_profiles(0)
+{
+}
+
+void UUIDSet::setUUIDs(const QStringList &UUIDs)
+{
+    m_UUIDs = UUIDs;
+    m_packed.clear();
+    m_packed.reserve(UUIDs.size());
+    m_profiles = 0;
+
+    for (int i = 0; i < m_UUIDs.size(); ++i) {
+        m_UUIDs[i] = m_UUIDs.at(i).toUpper();
+        PackedUUID packed;
+        if (packUUID(m_UUIDs.at(i), &packed)) {
+            m_packed.append(packed);
+            m_profiles |= packedUUIDToProfile(packed);
+        }
+    }
+}
+
+const QStringList &UUIDSet::UUIDs() const
+{
+    return m_UUIDs;
+}
+
+quint32 UUIDSet::profiles() const
+{
+    return m_profiles;
+}
+
+bool UUIDSet::contains(const QString &UUID) const
+{
+    PackedUUID packed;
+    if (!packUUID(UUID, &packed)) {
+        return false;
+    }
+    // Devices list a handful of UUIDs, a linear scan beats hashing
+    const PackedUUID *p = m_packed.constData();
+    const PackedUUID *const end = p + m_packed.size();
+    for (; p != end; ++p) {
+        if (*p == packed) {
+            return true;
+        }
+    }
+    return false;
+}
+
 }
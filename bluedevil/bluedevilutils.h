@@ -30,7 +30,9 @@
 namespace BlueDevil {
 
     quint32 BLUEDEVIL_EXPORT classToType(quint32 classNum);
+    quint32 BLUEDEVIL_EXPORT appearanceToType(quint16 appearance);
     quint32 BLUEDEVIL_EXPORT stringToType(const QString& stringType);
+    quint32 BLUEDEVIL_EXPORT UUIDToProfile(const QString &UUID);
 
     enum BluetoothType {
         BLUETOOTH_TYPE_ANY         = 1 << 0,
@@ -49,6 +51,28 @@ namespace BlueDevil {
         BLUETOOTH_TYPE_TABLET      = 1 << 13
     };
 
+    /**
+     * Well-known profiles, as returned by UUIDToProfile and Device::profiles. Profiles with
+     * several roles or versions (AVRCP, PBAP, PAN...) map all of their UUIDs to the same flag.
+     */
+    enum BluetoothProfile {
+        BLUETOOTH_PROFILE_A2DP_SOURCE  = 1 << 0,
+        BLUETOOTH_PROFILE_A2DP_SINK    = 1 << 1,
+        BLUETOOTH_PROFILE_AVRCP        = 1 << 2,
+        BLUETOOTH_PROFILE_HEADSET      = 1 << 3,
+        BLUETOOTH_PROFILE_HEADSET_AG   = 1 << 4,
+        BLUETOOTH_PROFILE_HANDSFREE    = 1 << 5,
+        BLUETOOTH_PROFILE_HANDSFREE_AG = 1 << 6,
+        BLUETOOTH_PROFILE_HID          = 1 << 7,
+        BLUETOOTH_PROFILE_PAN          = 1 << 8,
+        BLUETOOTH_PROFILE_OBEX_PUSH    = 1 << 9,
+        BLUETOOTH_PROFILE_OBEX_FTP     = 1 << 10,
+        BLUETOOTH_PROFILE_SERIAL       = 1 << 11,
+        BLUETOOTH_PROFILE_DUN          = 1 << 12,
+        BLUETOOTH_PROFILE_PBAP         = 1 << 13,
+        BLUETOOTH_PROFILE_MAP          = 1 << 14
+    };
+
 }
 
 #endif // BLUEDEVILUTILS_H
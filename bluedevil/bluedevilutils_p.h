@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef BLUEDEVILUTILS_P_H
+#define BLUEDEVILUTILS_P_H
+
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ *
+ * A UUID as a 128-bit big-endian value, so that comparing two of them is two integer comparisons
+ * regardless of how they were written.
+ */
+struct PackedUUID
+{
+    quint64 high;
+    quint64 low;
+
+    bool operator==(const PackedUUID &other) const
+    {
+        return high == other.high && low == other.low;
+    }
+};
+
+}
+
+Q_DECLARE_TYPEINFO(BlueDevil::PackedUUID, Q_PRIMITIVE_TYPE);
+
+namespace BlueDevil {
+
+/**
+ * @internal
+ *
+ * Packs an address like "00:11:22:AA:BB:CC" into the lower 48 bits of an integer, which is cheaper
+ * to hash and compare than the string, and does not care about the case of the hex digits.
+ */
+quint64 addressToKey(const QString &address);
+
+/**
+ * @internal
+ *
+ * Parses @p UUID, either in its 128-bit form or as a 16 or 32-bit alias of the Bluetooth base
+ * UUID ("110b", "0x110B"), in any case and with or without dashes.
+ *
+ * @return Whether @p UUID was valid. @p packed is left untouched otherwise.
+ */
+bool packUUID(const QString &UUID, PackedUUID *packed);
+
+/**
+ * @internal
+ *
+ * @return The BluetoothProfile flag of @p UUID, or 0 if it is not a well-known profile.
+ */
+quint32 packedUUIDToProfile(const PackedUUID &UUID);
+
+/**
+ * @internal
+ *
+ * The UUIDs property of a device or adapter. It is normalized when it changes, so that lookups
+ * do not need to allocate.
+ */
+class UUIDSet
+{
+public:
+    UUIDSet();
+
+    void setUUIDs(const QStringList &UUIDs);
+
+    /**
+     * @return The UUIDs as reported by BlueZ, in uppercase.
+     */
+    const QStringList &UUIDs() const;
+
+    /**
+     * @return The BluetoothProfile flags of all the UUIDs.
+     */
+    quint32 profiles() const;
+
+    bool contains(const QString &UUID) const;
+
+private:
+    QStringList          m_UUIDs;
+    QVector<PackedUUID>  m_packed;
+    quint32              m_profiles;
+};
+
+}
+
+#endif // BLUEDEVILUTILS_P_H
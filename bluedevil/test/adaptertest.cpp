@@ -74,10 +74,11 @@ void AdapterTest::allAdaptersRemoved()
 
 void AdapterTest::run()
 {
-    Manager *const manager = Manager::self();
+    // The Manager belongs to the main thread, only its published info can be read from here
     while (true) {
-        qDebug() << "Bluetooth Operational: " << manager->isBluetoothOperational();
-        qDebug() << "Usable Adapter: " << manager->usableAdapter();
+        const ManagerInfo info = Manager::info();
+        qDebug() << "Bluetooth Operational: " << info.isBluetoothOperational();
+        qDebug() << "Usable Adapter: " << info.usableAdapter().UBI();
         sleep(5);
     }
 }
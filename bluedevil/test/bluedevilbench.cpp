@@ -0,0 +1,233 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+
+#include "bluedevilbench.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtTest/QTest>
+
+#include <bluedevil/bluedeviladapter.h>
+#include <bluedevil/bluedevilmanager.h>
+#include <bluedevil/bluedevildevice.h>
+
+#include <unistd.h>
+
+using namespace BlueDevil;
+
+static const char *firstAdapterPath = "/org/bluez/hci0";
+
+static qint64 residentMemory()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.value(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+BlueDevilBench::BlueDevilBench(QObject *parent)
+    : QObject(parent)
+    , m_deviceChangedCount(0)
+{
+}
+
+void BlueDevilBench::countDeviceChanged()
+{
+    ++m_deviceChangedCount;
+}
+
+void BlueDevilBench::initTestCase()
+{
+    QVERIFY(m_fixture.startBus());
+}
+
+void BlueDevilBench::cleanup()
+{
+    Manager::release();
+    m_fixture.stopBluez();
+}
+
+void BlueDevilBench::startup_data()
+{
+    QTest::addColumn<int>("devices");
+
+    QTest::newRow("10 devices") << 10;
+    QTest::newRow("1k devices") << 1000;
+    QTest::newRow("10k devices") << 10000;
+}
+
+void BlueDevilBench::startup()
+{
+    QFETCH(int, devices);
+    QVERIFY(m_fixture.startBluez(1, devices));
+
+    QBENCHMARK {
+        Manager *const manager = Manager::self();
+        QCOMPARE(manager->devices().count(), devices);
+        Manager::release();
+    }
+}
+
+void BlueDevilBench::propertyAccess_data()
+{
+    QTest::addColumn<QString>("property");
+
+    QTest::newRow("name") << "name";
+    QTest::newRow("isPaired") << "isPaired";
+    QTest::newRow("UUIDs") << "UUIDs";
+}
+
+void BlueDevilBench::propertyAccess()
+{
+    QFETCH(QString, property);
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Device *const device = Manager::self()->devices().value(0);
+    QVERIFY(device);
+
+    int result = 0;
+    if (property == "name") {
+        QBENCHMARK {
+            result += device->name().size();
+        }
+    } else if (property == "isPaired") {
+        QBENCHMARK {
+            result += device->isPaired();
+        }
+    } else if (property == "UUIDs") {
+        QBENCHMARK {
+            result += device->UUIDs().size();
+        }
+    }
+    QVERIFY(result >= 0);
+}
+
+void BlueDevilBench::propertyChangedThroughput_data()
+{
+    QTest::addColumn<int>("devices");
+    QTest::addColumn<int>("changes");
+
+    QTest::newRow("10 devices") << 10 << 20000;
+    QTest::newRow("1k devices") << 1000 << 20000;
+}
+
+void BlueDevilBench::propertyChangedThroughput()
+{
+    QFETCH(int, devices);
+    QFETCH(int, changes);
+    QVERIFY(m_fixture.startBluez(1, devices));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    connect(adapter, SIGNAL(deviceChanged(Device*)), this, SLOT(countDeviceChanged()));
+    m_deviceChangedCount = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    // As fast as fakebluez can send them
+    m_fixture.startPropertyChanges("RSSI", changes, 1000000);
+    while (m_deviceChangedCount < changes && timer.elapsed() < 60000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    QCOMPARE(m_deviceChangedCount, changes);
+    // The inverse of the throughput, QTestLib has no metric for events per second
+    QTest::setBenchmarkResult(qreal(elapsed) / changes, QTest::WalltimeNanoseconds);
+}
+
+void BlueDevilBench::memoryPerDevice_data()
+{
+    QTest::addColumn<int>("devices");
+
+    QTest::newRow("1k devices") << 1000;
+    QTest::newRow("10k devices") << 10000;
+}
+
+void BlueDevilBench::memoryPerDevice()
+{
+    QFETCH(int, devices);
+    QVERIFY(m_fixture.startBluez(1, devices));
+
+    // Bring up everything that is not per device (connection, metatypes...) before measuring
+    Manager::self();
+    Manager::release();
+
+    const qint64 before = residentMemory();
+    QCOMPARE(Manager::self()->devices().count(), devices);
+    const qint64 after = residentMemory();
+
+    QTest::setBenchmarkResult(qreal(after - before) / devices, QTest::BytesAllocated);
+}
+
+void BlueDevilBench::insertRemove_data()
+{
+    QTest::addColumn<bool>("insert");
+    QTest::addColumn<int>("devices");
+
+    QTest::newRow("insert 100 devices") << true << 100;
+    QTest::newRow("remove 100 devices") << false << 100;
+    QTest::newRow("insert 1k devices") << true << 1000;
+    QTest::newRow("remove 1k devices") << false << 1000;
+    QTest::newRow("insert 10k devices") << true << 10000;
+    QTest::newRow("remove 10k devices") << false << 10000;
+    QTest::newRow("insert 50k devices") << true << 50000;
+    QTest::newRow("remove 50k devices") << false << 50000;
+}
+
+void BlueDevilBench::insertRemove()
+{
+    QFETCH(bool, insert);
+    QFETCH(int, devices);
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+
+    // The control calls return once fakebluez has sent every InterfacesAdded/InterfacesRemoved, so
+    // the timers only measure how fast the library digests them. Per device costs should not grow
+    // with the number of devices.
+    QElapsedTimer timer;
+    QCOMPARE(m_fixture.addDevices(firstAdapterPath, devices).count(), devices);
+    timer.start();
+    while (adapter->devices().count() < devices && timer.elapsed() < 120000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    }
+    QCOMPARE(adapter->devices().count(), devices);
+    if (insert) {
+        QTest::setBenchmarkResult(qreal(timer.nsecsElapsed()) / devices, QTest::WalltimeNanoseconds);
+        return;
+    }
+
+    QCOMPARE(m_fixture.removeDevices(firstAdapterPath), devices);
+    timer.start();
+    while (!adapter->devices().isEmpty() && timer.elapsed() < 120000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    }
+    QVERIFY(adapter->devices().isEmpty());
+    QTest::setBenchmarkResult(qreal(timer.nsecsElapsed()) / devices, QTest::WalltimeNanoseconds);
+}
+
+QTEST_MAIN(BlueDevilBench)
+
+#include "bluedevilbench.moc"
@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+
+#ifndef BLUEDEVILBENCH_H
+#define BLUEDEVILBENCH_H
+
+#include "fakebluezfixture.h"
+
+#include <QtCore/QObject>
+
+/**
+ * Benchmarks run against fakebluez on a private bus.
+ *
+ * Run it with "-xml" or "-csv" to get machine readable results. Every test function, or data row,
+ * reports a single figure. Those that are not timings of a QBENCHMARK block are reported through
+ * QTest::setBenchmarkResult: nanoseconds per event or per device, and bytes per device.
+ */
+class BlueDevilBench
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    BlueDevilBench(QObject *parent = 0);
+
+public Q_SLOTS:
+    void countDeviceChanged();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void startup_data();
+    void startup();
+    void propertyAccess_data();
+    void propertyAccess();
+    void propertyChangedThroughput_data();
+    void propertyChangedThroughput();
+    void memoryPerDevice_data();
+    void memoryPerDevice();
+    void insertRemove_data();
+    void insertRemove();
+
+private:
+    FakeBluezFixture m_fixture;
+    int              m_deviceChangedCount;
+};
+
+#endif // BLUEDEVILBENCH_H
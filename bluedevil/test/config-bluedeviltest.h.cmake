@@ -0,0 +1,3 @@
+#define DBUS_DAEMON_EXECUTABLE "${DBUS_DAEMON_EXECUTABLE}"
+#define FAKEBLUEZ_EXECUTABLE "${CMAKE_CURRENT_BINARY_DIR}/fakebluez"
+#define TEST_BUS_CONFIG "${CMAKE_CURRENT_SOURCE_DIR}/test-bus.conf"
@@ -0,0 +1,867 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "fakebluez.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusMetaType>
+
+static const char *adapterInterface = "org.bluez.Adapter1";
+static const char *deviceInterface = "org.bluez.Device1";
+
+FakeObject::FakeObject(const QString &path, const QString &interface, const QVariantMap &properties, FakeBluez *bluez)
+    : QObject(bluez)
+    , m_path(path)
+    , m_interface(interface)
+    , m_properties(properties)
+    , m_bluez(bluez)
+{
+}
+
+FakeObject::~FakeObject()
+{
+}
+
+QString FakeObject::path() const
+{
+    return m_path;
+}
+
+QString FakeObject::interface() const
+{
+    return m_interface;
+}
+
+QVariantMap FakeObject::properties() const
+{
+    return m_properties;
+}
+
+FakeBluez *FakeObject::bluez() const
+{
+    return m_bluez;
+}
+
+QVariant FakeObject::value(const QString &property) const
+{
+    return m_properties.value(property);
+}
+
+void FakeObject::setValue(const QString &property, const QVariant &value)
+{
+    if (m_properties.value(property) == value) {
+        return;
+    }
+    m_properties.insert(property, value);
+
+    QVariantMap changed;
+    changed.insert(property, value);
+    m_bluez->emitPropertiesChanged(this, changed);
+}
+
+void FakeObject::invalidate(const QString &property)
+{
+    if (!m_properties.remove(property)) {
+        return;
+    }
+    m_bluez->emitPropertiesChanged(this, QVariantMap(), QStringList() << property);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FakeAdapter1::FakeAdapter1(FakeObject *object)
+    : QDBusAbstractAdaptor(object)
+    , m_object(object)
+{
+}
+
+QString FakeAdapter1::address() const
+{
+    return m_object->value("Address").toString();
+}
+
+QString FakeAdapter1::name() const
+{
+    return m_object->value("Name").toString();
+}
+
+QString FakeAdapter1::alias() const
+{
+    return m_object->value("Alias").toString();
+}
+
+void FakeAdapter1::setAlias(const QString &alias)
+{
+    m_object->setValue("Alias", alias);
+}
+
+uint FakeAdapter1::adapterClass() const
+{
+    return m_object->value("Class").toUInt();
+}
+
+bool FakeAdapter1::powered() const
+{
+    return m_object->value("Powered").toBool();
+}
+
+void FakeAdapter1::setPowered(bool powered)
+{
+    m_object->setValue("Powered", powered);
+}
+
+bool FakeAdapter1::discoverable() const
+{
+    return m_object->value("Discoverable").toBool();
+}
+
+void FakeAdapter1::setDiscoverable(bool discoverable)
+{
+    m_object->setValue("Discoverable", discoverable);
+}
+
+uint FakeAdapter1::discoverableTimeout() const
+{
+    return m_object->value("DiscoverableTimeout").toUInt();
+}
+
+void FakeAdapter1::setDiscoverableTimeout(uint timeout)
+{
+    m_object->setValue("DiscoverableTimeout", timeout);
+}
+
+bool FakeAdapter1::pairable() const
+{
+    return m_object->value("Pairable").toBool();
+}
+
+void FakeAdapter1::setPairable(bool pairable)
+{
+    m_object->setValue("Pairable", pairable);
+}
+
+uint FakeAdapter1::pairableTimeout() const
+{
+    return m_object->value("PairableTimeout").toUInt();
+}
+
+void FakeAdapter1::setPairableTimeout(uint timeout)
+{
+    m_object->setValue("PairableTimeout", timeout);
+}
+
+bool FakeAdapter1::discovering() const
+{
+    return m_object->value("Discovering").toBool();
+}
+
+QStringList FakeAdapter1::UUIDs() const
+{
+    return m_object->value("UUIDs").toStringList();
+}
+
+QString FakeAdapter1::modalias() const
+{
+    return m_object->value("Modalias").toString();
+}
+
+void FakeAdapter1::StartDiscovery()
+{
+    m_object->setValue("Discovering", true);
+}
+
+void FakeAdapter1::StopDiscovery()
+{
+    m_object->setValue("Discovering", false);
+}
+
+QVariantMap FakeAdapter1::discoveryFilter() const
+{
+    return m_discoveryFilter;
+}
+
+void FakeAdapter1::SetDiscoveryFilter(const QVariantMap &filter)
+{
+    static const QStringList knownKeys = QStringList() << "Transport" << "RSSI" << "Pathloss"
+                                                       << "UUIDs" << "DuplicateData";
+    const QStringList transports = QStringList() << "auto" << "bredr" << "le";
+
+    bool valid = !(filter.contains("RSSI") && filter.contains("Pathloss"));
+    if (filter.contains("Transport") && !transports.contains(filter.value("Transport").toString())) {
+        valid = false;
+    }
+    Q_FOREACH (const QString &key, filter.keys()) {
+        valid = valid && knownKeys.contains(key);
+    }
+
+    if (!valid) {
+        sendErrorReply("org.bluez.Error.InvalidArguments", "Invalid arguments in method call");
+        return;
+    }
+    m_discoveryFilter = filter;
+}
+
+void FakeAdapter1::RemoveDevice(const QDBusObjectPath &device)
+{
+    m_object->bluez()->removeDevice(device.path());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FakeDevice1::FakeDevice1(FakeObject *object)
+    : QDBusAbstractAdaptor(object)
+    , m_object(object)
+{
+}
+
+QString FakeDevice1::address() const
+{
+    return m_object->value("Address").toString();
+}
+
+QString FakeDevice1::name() const
+{
+    return m_object->value("Name").toString();
+}
+
+QString FakeDevice1::alias() const
+{
+    return m_object->value("Alias").toString();
+}
+
+void FakeDevice1::setAlias(const QString &alias)
+{
+    m_object->setValue("Alias", alias);
+}
+
+uint FakeDevice1::deviceClass() const
+{
+    return m_object->value("Class").toUInt();
+}
+
+ushort FakeDevice1::appearance() const
+{
+    return m_object->value("Appearance").value<ushort>();
+}
+
+QString FakeDevice1::icon() const
+{
+    return m_object->value("Icon").toString();
+}
+
+bool FakeDevice1::paired() const
+{
+    return m_object->value("Paired").toBool();
+}
+
+bool FakeDevice1::trusted() const
+{
+    return m_object->value("Trusted").toBool();
+}
+
+void FakeDevice1::setTrusted(bool trusted)
+{
+    m_object->setValue("Trusted", trusted);
+}
+
+bool FakeDevice1::blocked() const
+{
+    return m_object->value("Blocked").toBool();
+}
+
+void FakeDevice1::setBlocked(bool blocked)
+{
+    m_object->setValue("Blocked", blocked);
+}
+
+bool FakeDevice1::legacyPairing() const
+{
+    return m_object->value("LegacyPairing").toBool();
+}
+
+short FakeDevice1::rssi() const
+{
+    return m_object->value("RSSI").value<short>();
+}
+
+bool FakeDevice1::connected() const
+{
+    return m_object->value("Connected").toBool();
+}
+
+QStringList FakeDevice1::UUIDs() const
+{
+    return m_object->value("UUIDs").toStringList();
+}
+
+QString FakeDevice1::modalias() const
+{
+    return m_object->value("Modalias").toString();
+}
+
+QDBusObjectPath FakeDevice1::adapter() const
+{
+    return m_object->value("Adapter").value<QDBusObjectPath>();
+}
+
+void FakeDevice1::Connect()
+{
+    if (m_object->bluez()->holdsConnects()) {
+        setDelayedReply(true);
+        m_object->bluez()->holdConnect(message());
+        return;
+    }
+    m_object->setValue("Connected", true);
+}
+
+void FakeDevice1::Disconnect()
+{
+    m_object->setValue("Connected", false);
+}
+
+void FakeDevice1::ConnectProfile(const QString &UUID)
+{
+    if (!UUIDs().contains(UUID, Qt::CaseInsensitive)) {
+        sendErrorReply("org.bluez.Error.InvalidArguments", "Invalid arguments in method call");
+        return;
+    }
+    m_object->setValue("Connected", true);
+}
+
+void FakeDevice1::DisconnectProfile(const QString &UUID)
+{
+    if (!UUIDs().contains(UUID, Qt::CaseInsensitive)) {
+        sendErrorReply("org.bluez.Error.InvalidArguments", "Invalid arguments in method call");
+        return;
+    }
+    m_object->setValue("Connected", false);
+}
+
+void FakeDevice1::Pair()
+{
+    if (m_object->value("Paired").toBool()) {
+        sendErrorReply("org.bluez.Error.AlreadyExists", "Already Paired");
+        return;
+    }
+    m_object->setValue("Paired", true);
+}
+
+void FakeDevice1::CancelPairing()
+{
+    // Pair() completes right away, so there is never a pairing in progress
+    sendErrorReply("org.bluez.Error.DoesNotExist", "Does Not Exist");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FakeAgentManager1::FakeAgentManager1(QObject *object, FakeBluez *bluez)
+    : QDBusAbstractAdaptor(object)
+    , m_bluez(bluez)
+{
+}
+
+void FakeAgentManager1::RegisterAgent(const QDBusObjectPath &agent, const QString &capability)
+{
+    Q_UNUSED(capability);
+    m_bluez->registerAgent(agent.path());
+}
+
+void FakeAgentManager1::UnregisterAgent(const QDBusObjectPath &agent)
+{
+    m_bluez->unregisterAgent(agent.path());
+}
+
+void FakeAgentManager1::RequestDefaultAgent(const QDBusObjectPath &agent)
+{
+    m_bluez->requestDefaultAgent(agent.path());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FakeObjectManager::FakeObjectManager(FakeBluez *bluez)
+    : QDBusAbstractAdaptor(bluez)
+    , m_bluez(bluez)
+{
+}
+
+DBusManagerStruct FakeObjectManager::GetManagedObjects()
+{
+    if (m_bluez->holdsManagedObjects()) {
+        // Answered with the objects as they are now, but only sent once released
+        setDelayedReply(true);
+        m_bluez->holdReply(message().createReply(QVariant::fromValue(m_bluez->managedObjects())));
+        return DBusManagerStruct();
+    }
+    return m_bluez->managedObjects();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FakeBluezControl::FakeBluezControl(FakeBluez *bluez)
+    : QDBusAbstractAdaptor(bluez)
+    , m_bluez(bluez)
+{
+    connect(bluez, SIGNAL(propertyChangesFinished()), this, SIGNAL(PropertyChangesFinished()));
+}
+
+QString FakeBluezControl::AddAdapter(const QString &name, bool powered)
+{
+    return m_bluez->addAdapter(name, powered);
+}
+
+void FakeBluezControl::RemoveAdapter(const QString &path)
+{
+    m_bluez->removeAdapter(path);
+}
+
+QStringList FakeBluezControl::AddDevices(const QString &adapterPath, int count, bool paired)
+{
+    return m_bluez->addDevices(adapterPath, count, paired);
+}
+
+void FakeBluezControl::RemoveDevice(const QString &path)
+{
+    m_bluez->removeDevice(path);
+}
+
+int FakeBluezControl::RemoveDevices(const QString &adapterPath)
+{
+    return m_bluez->removeDevices(adapterPath);
+}
+
+bool FakeBluezControl::SetProperty(const QString &path, const QString &property, const QDBusVariant &value)
+{
+    return m_bluez->setObjectProperty(path, property, value.variant());
+}
+
+bool FakeBluezControl::InvalidateProperty(const QString &path, const QString &property)
+{
+    return m_bluez->invalidateObjectProperty(path, property);
+}
+
+void FakeBluezControl::StartPropertyChanges(const QString &property, int count, int rate)
+{
+    m_bluez->startPropertyChanges(property, count, rate);
+}
+
+QVariantMap FakeBluezControl::DiscoveryFilter(const QString &adapterPath)
+{
+    return m_bluez->discoveryFilter(adapterPath);
+}
+
+QStringList FakeBluezControl::Agents()
+{
+    return m_bluez->agents();
+}
+
+void FakeBluezControl::HoldConnects(bool hold)
+{
+    m_bluez->setHoldConnects(hold);
+}
+
+void FakeBluezControl::HoldManagedObjects(bool hold)
+{
+    m_bluez->setHoldManagedObjects(hold);
+}
+
+void FakeBluezControl::Quit()
+{
+    QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FakeBluez::FakeBluez(QObject *parent)
+    : QObject(parent)
+    , m_adapterCount(0)
+    , m_deviceCount(0)
+    , m_holdConnects(false)
+    , m_holdManagedObjects(false)
+    , m_changesRemaining(0)
+    , m_changesPerTick(1)
+    , m_changesCounter(0)
+{
+    qDBusRegisterMetaType<QVariantMapMap>();
+    qDBusRegisterMetaType<DBusManagerStruct>();
+
+    m_objectManager = new FakeObjectManager(this);
+    new FakeBluezControl(this);
+
+    m_agentManagerObject = new QObject(this);
+    new FakeAgentManager1(m_agentManagerObject, this);
+
+    connect(&m_changesTimer, SIGNAL(timeout()), this, SLOT(firePropertyChanges()));
+}
+
+FakeBluez::~FakeBluez()
+{
+}
+
+bool FakeBluez::registerService()
+{
+    QDBusConnection bus = QDBusConnection::systemBus();
+    if (!bus.registerObject("/", this, QDBusConnection::ExportAdaptors)) {
+        return false;
+    }
+    if (!bus.registerObject("/org/bluez", m_agentManagerObject, QDBusConnection::ExportAdaptors)) {
+        return false;
+    }
+    return bus.registerService("org.bluez");
+}
+
+QString FakeBluez::addAdapter(const QString &name, bool powered)
+{
+    const int index = m_adapterCount++;
+    const QString path = QString("/org/bluez/hci%1").arg(index);
+
+    QVariantMap properties;
+    properties.insert("Address", QString("00:1A:7D:DA:71:%1").arg(index, 2, 16, QChar('0')).toUpper());
+    properties.insert("Name", name);
+    properties.insert("Alias", name);
+    properties.insert("Class", 0x0c010cu);
+    properties.insert("Powered", powered);
+    properties.insert("Discoverable", false);
+    properties.insert("DiscoverableTimeout", 180u);
+    properties.insert("Pairable", true);
+    properties.insert("PairableTimeout", 0u);
+    properties.insert("Discovering", false);
+    properties.insert("UUIDs", QStringList() << "00001200-0000-1000-8000-00805f9b34fb"
+                                             << "0000110e-0000-1000-8000-00805f9b34fb");
+    properties.insert("Modalias", QString("usb:v1D6Bp0246d0525"));
+
+    FakeObject *const object = new FakeObject(path, adapterInterface, properties, this);
+    new FakeAdapter1(object);
+    exportObject(object);
+    return path;
+}
+
+void FakeBluez::removeAdapter(const QString &path)
+{
+    FakeObject *const adapter = m_objects.value(path);
+    if (!adapter || adapter->interface() != adapterInterface) {
+        return;
+    }
+
+    // Like bluetoothd, devices go away before their adapter
+    removeDevices(path);
+
+    m_objects.remove(path);
+    QDBusConnection::systemBus().unregisterObject(path);
+    emit m_objectManager->InterfacesRemoved(QDBusObjectPath(path), QStringList() << adapterInterface);
+    delete adapter;
+}
+
+QStringList FakeBluez::addDevices(const QString &adapterPath, int count, bool paired)
+{
+    QStringList paths;
+    if (!m_objects.contains(adapterPath)) {
+        return paths;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const int index = m_deviceCount++;
+        const QString address = QString("00:11:%1:%2:%3:%4").arg((index >> 24) & 0xff, 2, 16, QChar('0'))
+                                                             .arg((index >> 16) & 0xff, 2, 16, QChar('0'))
+                                                             .arg((index >> 8) & 0xff, 2, 16, QChar('0'))
+                                                             .arg(index & 0xff, 2, 16, QChar('0')).toUpper();
+        QString path = address;
+        path.replace(':', '_');
+        path.prepend(adapterPath + "/dev_");
+
+        const QString name = QString("Device %1").arg(index);
+        QVariantMap properties;
+        properties.insert("Address", address);
+        properties.insert("Name", name);
+        properties.insert("Alias", name);
+        properties.insert("Class", 0x240404u);
+        properties.insert("Appearance", QVariant::fromValue<ushort>(0));
+        properties.insert("Icon", QString("audio-card"));
+        properties.insert("Paired", paired);
+        properties.insert("Trusted", paired);
+        properties.insert("Blocked", false);
+        properties.insert("LegacyPairing", false);
+        properties.insert("RSSI", QVariant::fromValue<short>(-60));
+        properties.insert("Connected", false);
+        properties.insert("UUIDs", QStringList() << "0000110b-0000-1000-8000-00805f9b34fb"
+                                                 << "0000111e-0000-1000-8000-00805f9b34fb");
+        properties.insert("Modalias", QString("bluetooth:v000Ap1234d0100"));
+        properties.insert("Adapter", QVariant::fromValue(QDBusObjectPath(adapterPath)));
+
+        FakeObject *const object = new FakeObject(path, deviceInterface, properties, this);
+        new FakeDevice1(object);
+        exportObject(object);
+        paths << path;
+    }
+    return paths;
+}
+
+void FakeBluez::removeDevice(const QString &path)
+{
+    FakeObject *const device = m_objects.value(path);
+    if (!device || device->interface() != deviceInterface) {
+        return;
+    }
+
+    m_objects.remove(path);
+    QDBusConnection::systemBus().unregisterObject(path);
+    emit m_objectManager->InterfacesRemoved(QDBusObjectPath(path), QStringList() << deviceInterface);
+    delete device;
+}
+
+int FakeBluez::removeDevices(const QString &adapterPath)
+{
+    int count = 0;
+    Q_FOREACH (FakeObject *const object, m_objects) {
+        if (object->interface() == deviceInterface &&
+            object->value("Adapter").value<QDBusObjectPath>().path() == adapterPath) {
+            removeDevice(object->path());
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool FakeBluez::setObjectProperty(const QString &path, const QString &property, const QVariant &value)
+{
+    FakeObject *const object = m_objects.value(path);
+    if (!object) {
+        return false;
+    }
+    object->setValue(property, value);
+    return true;
+}
+
+bool FakeBluez::invalidateObjectProperty(const QString &path, const QString &property)
+{
+    FakeObject *const object = m_objects.value(path);
+    if (!object) {
+        return false;
+    }
+    object->invalidate(property);
+    return true;
+}
+
+void FakeBluez::startPropertyChanges(const QString &property, int count, int rate)
+{
+    m_changesProperty = property;
+    m_changesDevices.clear();
+    Q_FOREACH (FakeObject *const object, m_objects) {
+        if (object->interface() == deviceInterface) {
+            m_changesDevices << object->path();
+        }
+    }
+    m_changesRemaining = count;
+    m_changesCounter = 0;
+
+    // Timers have a resolution of one millisecond, so higher rates are fired in batches
+    rate = qMax(1, rate);
+    m_changesPerTick = qMax(1, rate / 1000);
+    m_changesTimer.start(qMax(1, 1000 / rate));
+}
+
+bool FakeBluez::holdsConnects() const
+{
+    return m_holdConnects;
+}
+
+void FakeBluez::setHoldConnects(bool hold)
+{
+    m_holdConnects = hold;
+    if (hold) {
+        return;
+    }
+
+    const QList<QDBusMessage> held = m_heldConnects;
+    m_heldConnects.clear();
+    Q_FOREACH (const QDBusMessage &message, held) {
+        // Like bluetoothd, a device removed while it was being paged never answers
+        FakeObject *const object = m_objects.value(message.path());
+        if (!object) {
+            continue;
+        }
+        object->setValue("Connected", true);
+        QDBusConnection::systemBus().send(message.createReply());
+    }
+}
+
+void FakeBluez::holdConnect(const QDBusMessage &message)
+{
+    m_heldConnects.append(message);
+}
+
+bool FakeBluez::holdsManagedObjects() const
+{
+    return m_holdManagedObjects;
+}
+
+void FakeBluez::setHoldManagedObjects(bool hold)
+{
+    m_holdManagedObjects = hold;
+    if (hold) {
+        return;
+    }
+
+    Q_FOREACH (const QDBusMessage &reply, m_heldReplies) {
+        QDBusConnection::systemBus().send(reply);
+    }
+    m_heldReplies.clear();
+}
+
+void FakeBluez::holdReply(const QDBusMessage &reply)
+{
+    m_heldReplies.append(reply);
+}
+
+DBusManagerStruct FakeBluez::managedObjects() const
+{
+    DBusManagerStruct objects;
+
+    QVariantMapMap agentManager;
+    agentManager.insert("org.bluez.AgentManager1", QVariantMap());
+    objects.insert(QDBusObjectPath("/org/bluez"), agentManager);
+
+    Q_FOREACH (FakeObject *const object, m_objects) {
+        QVariantMapMap interfaces;
+        interfaces.insert(object->interface(), object->properties());
+        objects.insert(QDBusObjectPath(object->path()), interfaces);
+    }
+    return objects;
+}
+
+void FakeBluez::registerAgent(const QString &agent)
+{
+    if (!m_agents.contains(agent)) {
+        m_agents << agent;
+    }
+}
+
+void FakeBluez::unregisterAgent(const QString &agent)
+{
+    m_agents.removeAll(agent);
+    if (m_defaultAgent == agent) {
+        m_defaultAgent.clear();
+    }
+}
+
+void FakeBluez::requestDefaultAgent(const QString &agent)
+{
+    m_defaultAgent = agent;
+}
+
+QVariantMap FakeBluez::discoveryFilter(const QString &adapterPath) const
+{
+    FakeObject *const object = m_objects.value(adapterPath);
+    FakeAdapter1 *const adapter = object ? object->findChild<FakeAdapter1*>() : 0;
+    return adapter ? adapter->discoveryFilter() : QVariantMap();
+}
+
+QStringList FakeBluez::agents() const
+{
+    return m_agents;
+}
+
+void FakeBluez::emitPropertiesChanged(FakeObject *object, const QVariantMap &changed, const QStringList &invalidated)
+{
+    QDBusMessage message = QDBusMessage::createSignal(object->path(), "org.freedesktop.DBus.Properties", "PropertiesChanged");
+    message << object->interface() << changed << invalidated;
+    QDBusConnection::systemBus().send(message);
+}
+
+void FakeBluez::firePropertyChanges()
+{
+    for (int i = 0; i < m_changesPerTick && m_changesRemaining > 0 && !m_changesDevices.isEmpty(); ++i, --m_changesRemaining) {
+        const int counter = m_changesCounter++;
+        FakeObject *const device = m_objects.value(m_changesDevices.at(counter % m_changesDevices.count()));
+        if (!device) {
+            continue;
+        }
+
+        QVariant value;
+        if (m_changesProperty == "RSSI") {
+            // Each round over the devices must change every value, or no signal would be sent
+            value = QVariant::fromValue<short>(-40 - (counter / m_changesDevices.count()) % 50);
+        } else if (m_changesProperty == "Name" || m_changesProperty == "Alias") {
+            value = QString("Device %1").arg(counter);
+        } else {
+            value = !device->value(m_changesProperty).toBool();
+        }
+        device->setValue(m_changesProperty, value);
+    }
+
+    if (m_changesRemaining <= 0 || m_changesDevices.isEmpty()) {
+        m_changesTimer.stop();
+        emit propertyChangesFinished();
+    }
+}
+
+void FakeBluez::exportObject(FakeObject *object)
+{
+    m_objects.insert(object->path(), object);
+    QDBusConnection::systemBus().registerObject(object->path(), object, QDBusConnection::ExportAdaptors);
+
+    QVariantMapMap interfaces;
+    interfaces.insert(object->interface(), object->properties());
+    emit m_objectManager->InterfacesAdded(QDBusObjectPath(object->path()), interfaces);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    int adapters = 1;
+    int devices = 0;
+    int paired = 0;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.count() - 1; ++i) {
+        if (args.at(i) == "--adapters") {
+            adapters = args.at(i + 1).toInt();
+        } else if (args.at(i) == "--devices") {
+            devices = args.at(i + 1).toInt();
+        } else if (args.at(i) == "--paired") {
+            paired = args.at(i + 1).toInt();
+        }
+    }
+
+    if (!QDBusConnection::systemBus().isConnected()) {
+        qWarning() << "fakebluez: cannot connect to the bus set in DBUS_SYSTEM_BUS_ADDRESS";
+        return 1;
+    }
+
+    // Populate before taking the name, so clients find everything through GetManagedObjects
+    FakeBluez bluez;
+    for (int i = 0; i < adapters; ++i) {
+        const QString adapter = bluez.addAdapter(QString("fakebluez #%1").arg(i), true);
+        bluez.addDevices(adapter, qMin(paired, devices), true);
+        bluez.addDevices(adapter, devices - qMin(paired, devices), false);
+    }
+
+    if (!bluez.registerService()) {
+        qWarning() << "fakebluez: cannot register org.bluez";
+        return 1;
+    }
+
+    return app.exec();
+}
+
+#include "fakebluez.moc"
@@ -0,0 +1,326 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef FAKEBLUEZ_H
+#define FAKEBLUEZ_H
+
+#include <QtCore/QObject>
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+#include <QtCore/QVariant>
+#include <QtDBus/QDBusAbstractAdaptor>
+#include <QtDBus/QDBusContext>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusVariant>
+
+#include <bluedevil/bluedevildbustypes.h>
+
+class FakeBluez;
+
+/**
+ * An object exported by the fake BlueZ service. It holds the properties of its BlueZ interface
+ * and emits org.freedesktop.DBus.Properties.PropertiesChanged when any of them changes.
+ */
+class FakeObject
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    FakeObject(const QString &path, const QString &interface, const QVariantMap &properties, FakeBluez *bluez);
+    virtual ~FakeObject();
+
+    QString path() const;
+    QString interface() const;
+    QVariantMap properties() const;
+    FakeBluez *bluez() const;
+
+    QVariant value(const QString &property) const;
+    void setValue(const QString &property, const QVariant &value);
+    void invalidate(const QString &property);
+
+private:
+    QString      m_path;
+    QString      m_interface;
+    QVariantMap  m_properties;
+    FakeBluez   *m_bluez;
+};
+
+class FakeAdapter1
+    : public QDBusAbstractAdaptor
+    , protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.bluez.Adapter1")
+
+    Q_PROPERTY(QString Address READ address)
+    Q_PROPERTY(QString Name READ name)
+    Q_PROPERTY(QString Alias READ alias WRITE setAlias)
+    Q_PROPERTY(uint Class READ adapterClass)
+    Q_PROPERTY(bool Powered READ powered WRITE setPowered)
+    Q_PROPERTY(bool Discoverable READ discoverable WRITE setDiscoverable)
+    Q_PROPERTY(uint DiscoverableTimeout READ discoverableTimeout WRITE setDiscoverableTimeout)
+    Q_PROPERTY(bool Pairable READ pairable WRITE setPairable)
+    Q_PROPERTY(uint PairableTimeout READ pairableTimeout WRITE setPairableTimeout)
+    Q_PROPERTY(bool Discovering READ discovering)
+    Q_PROPERTY(QStringList UUIDs READ UUIDs)
+    Q_PROPERTY(QString Modalias READ modalias)
+
+public:
+    FakeAdapter1(FakeObject *object);
+
+    QString address() const;
+    QString name() const;
+    QString alias() const;
+    void setAlias(const QString &alias);
+    uint adapterClass() const;
+    bool powered() const;
+    void setPowered(bool powered);
+    bool discoverable() const;
+    void setDiscoverable(bool discoverable);
+    uint discoverableTimeout() const;
+    void setDiscoverableTimeout(uint timeout);
+    bool pairable() const;
+    void setPairable(bool pairable);
+    uint pairableTimeout() const;
+    void setPairableTimeout(uint timeout);
+    bool discovering() const;
+    QStringList UUIDs() const;
+    QString modalias() const;
+
+    QVariantMap discoveryFilter() const;
+
+public Q_SLOTS:
+    void StartDiscovery();
+    void StopDiscovery();
+    void SetDiscoveryFilter(const QVariantMap &filter);
+    void RemoveDevice(const QDBusObjectPath &device);
+
+private:
+    FakeObject  *m_object;
+    QVariantMap  m_discoveryFilter;
+};
+
+class FakeDevice1
+    : public QDBusAbstractAdaptor
+    , protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.bluez.Device1")
+
+    Q_PROPERTY(QString Address READ address)
+    Q_PROPERTY(QString Name READ name)
+    Q_PROPERTY(QString Alias READ alias WRITE setAlias)
+    Q_PROPERTY(uint Class READ deviceClass)
+    Q_PROPERTY(ushort Appearance READ appearance)
+    Q_PROPERTY(QString Icon READ icon)
+    Q_PROPERTY(bool Paired READ paired)
+    Q_PROPERTY(bool Trusted READ trusted WRITE setTrusted)
+    Q_PROPERTY(bool Blocked READ blocked WRITE setBlocked)
+    Q_PROPERTY(bool LegacyPairing READ legacyPairing)
+    Q_PROPERTY(short RSSI READ rssi)
+    Q_PROPERTY(bool Connected READ connected)
+    Q_PROPERTY(QStringList UUIDs READ UUIDs)
+    Q_PROPERTY(QString Modalias READ modalias)
+    Q_PROPERTY(QDBusObjectPath Adapter READ adapter)
+
+public:
+    FakeDevice1(FakeObject *object);
+
+    QString address() const;
+    QString name() const;
+    QString alias() const;
+    void setAlias(const QString &alias);
+    uint deviceClass() const;
+    ushort appearance() const;
+    QString icon() const;
+    bool paired() const;
+    bool trusted() const;
+    void setTrusted(bool trusted);
+    bool blocked() const;
+    void setBlocked(bool blocked);
+    bool legacyPairing() const;
+    short rssi() const;
+    bool connected() const;
+    QStringList UUIDs() const;
+    QString modalias() const;
+    QDBusObjectPath adapter() const;
+
+public Q_SLOTS:
+    void Connect();
+    void Disconnect();
+    void ConnectProfile(const QString &UUID);
+    void DisconnectProfile(const QString &UUID);
+    void Pair();
+    void CancelPairing();
+
+private:
+    FakeObject *m_object;
+};
+
+class FakeAgentManager1
+    : public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.bluez.AgentManager1")
+
+public:
+    FakeAgentManager1(QObject *object, FakeBluez *bluez);
+
+public Q_SLOTS:
+    void RegisterAgent(const QDBusObjectPath &agent, const QString &capability);
+    void UnregisterAgent(const QDBusObjectPath &agent);
+    void RequestDefaultAgent(const QDBusObjectPath &agent);
+
+private:
+    FakeBluez *m_bluez;
+};
+
+class FakeObjectManager
+    : public QDBusAbstractAdaptor
+    , protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.DBus.ObjectManager")
+
+public:
+    FakeObjectManager(FakeBluez *bluez);
+
+public Q_SLOTS:
+    DBusManagerStruct GetManagedObjects();
+
+Q_SIGNALS:
+    void InterfacesAdded(const QDBusObjectPath &object, const QVariantMapMap &interfaces);
+    void InterfacesRemoved(const QDBusObjectPath &object, const QStringList &interfaces);
+
+private:
+    FakeBluez *m_bluez;
+};
+
+/**
+ * Scripting interface of the fake service, so tests can populate it and drive it from another
+ * process.
+ */
+class FakeBluezControl
+    : public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.BlueDevil.FakeBluez")
+
+public:
+    FakeBluezControl(FakeBluez *bluez);
+
+public Q_SLOTS:
+    QString AddAdapter(const QString &name, bool powered);
+    void RemoveAdapter(const QString &path);
+    QStringList AddDevices(const QString &adapterPath, int count, bool paired);
+    void RemoveDevice(const QString &path);
+    int RemoveDevices(const QString &adapterPath);
+    bool SetProperty(const QString &path, const QString &property, const QDBusVariant &value);
+    bool InvalidateProperty(const QString &path, const QString &property);
+    void StartPropertyChanges(const QString &property, int count, int rate);
+    QVariantMap DiscoveryFilter(const QString &adapterPath);
+    QStringList Agents();
+    void HoldConnects(bool hold);
+    void HoldManagedObjects(bool hold);
+    void Quit();
+
+Q_SIGNALS:
+    void PropertyChangesFinished();
+
+private:
+    FakeBluez *m_bluez;
+};
+
+/**
+ * A stand-in for bluetoothd. It implements org.bluez.Adapter1, org.bluez.Device1,
+ * org.bluez.AgentManager1 and org.freedesktop.DBus.ObjectManager on the system bus, which is
+ * expected to be a private bus set through DBUS_SYSTEM_BUS_ADDRESS.
+ */
+class FakeBluez
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    FakeBluez(QObject *parent = 0);
+    virtual ~FakeBluez();
+
+    bool registerService();
+
+    QString addAdapter(const QString &name, bool powered);
+    void removeAdapter(const QString &path);
+    QStringList addDevices(const QString &adapterPath, int count, bool paired);
+    void removeDevice(const QString &path);
+    int removeDevices(const QString &adapterPath);
+    bool setObjectProperty(const QString &path, const QString &property, const QVariant &value);
+    bool invalidateObjectProperty(const QString &path, const QString &property);
+    void startPropertyChanges(const QString &property, int count, int rate);
+    QVariantMap discoveryFilter(const QString &adapterPath) const;
+
+    DBusManagerStruct managedObjects() const;
+
+    void registerAgent(const QString &agent);
+    void unregisterAgent(const QString &agent);
+    void requestDefaultAgent(const QString &agent);
+    QStringList agents() const;
+
+    bool holdsConnects() const;
+    void setHoldConnects(bool hold);
+    void holdConnect(const QDBusMessage &message);
+
+    bool holdsManagedObjects() const;
+    void setHoldManagedObjects(bool hold);
+    void holdReply(const QDBusMessage &reply);
+
+    void emitPropertiesChanged(FakeObject *object, const QVariantMap &changed,
+                               const QStringList &invalidated = QStringList());
+
+Q_SIGNALS:
+    void propertyChangesFinished();
+
+private Q_SLOTS:
+    void firePropertyChanges();
+
+private:
+    void exportObject(FakeObject *object);
+
+    FakeObjectManager           *m_objectManager;
+    QObject                     *m_agentManagerObject;
+    QMap<QString, FakeObject*>   m_objects;
+    QStringList                  m_agents;
+    QString                      m_defaultAgent;
+    int                          m_adapterCount;
+    int                          m_deviceCount;
+    bool                         m_holdConnects;
+    QList<QDBusMessage>          m_heldConnects;
+    bool                         m_holdManagedObjects;
+    QList<QDBusMessage>          m_heldReplies;
+
+    QTimer                       m_changesTimer;
+    QString                      m_changesProperty;
+    QStringList                  m_changesDevices;
+    int                          m_changesRemaining;
+    int                          m_changesPerTick;
+    int                          m_changesCounter;
+};
+
+#endif // FAKEBLUEZ_H
@@ -0,0 +1,176 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "fakebluezfixture.h"
+#include "config-bluedeviltest.h"
+
+#include <QtCore/QDebug>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusArgument>
+#include <QtDBus/QDBusVariant>
+
+FakeBluezFixture::FakeBluezFixture()
+{
+}
+
+FakeBluezFixture::~FakeBluezFixture()
+{
+    stopBluez();
+    stopBus();
+}
+
+bool FakeBluezFixture::startBus()
+{
+    m_bus.start(DBUS_DAEMON_EXECUTABLE, QStringList() << "--config-file=" TEST_BUS_CONFIG
+                                                      << "--nofork"
+                                                      << "--print-address");
+    if (!m_bus.waitForStarted() || !m_bus.waitForReadyRead()) {
+        qWarning() << "Could not start" << DBUS_DAEMON_EXECUTABLE;
+        return false;
+    }
+
+    const QByteArray address = m_bus.readLine().trimmed();
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", address);
+    return QDBusConnection::systemBus().isConnected();
+}
+
+void FakeBluezFixture::stopBus()
+{
+    if (m_bus.state() == QProcess::NotRunning) {
+        return;
+    }
+    m_bus.terminate();
+    m_bus.waitForFinished();
+}
+
+bool FakeBluezFixture::startBluez(int adapters, int devices, int paired)
+{
+    m_bluez.setProcessChannelMode(QProcess::ForwardedChannels);
+    m_bluez.start(FAKEBLUEZ_EXECUTABLE, QStringList() << "--adapters" << QString::number(adapters)
+                                                      << "--devices" << QString::number(devices)
+                                                      << "--paired" << QString::number(paired));
+    if (!m_bluez.waitForStarted()) {
+        qWarning() << "Could not start" << FAKEBLUEZ_EXECUTABLE;
+        return false;
+    }
+    return waitForBluez(true);
+}
+
+void FakeBluezFixture::stopBluez()
+{
+    if (m_bluez.state() == QProcess::NotRunning) {
+        return;
+    }
+    m_bluez.terminate();
+    m_bluez.waitForFinished();
+    waitForBluez(false);
+}
+
+QString FakeBluezFixture::addAdapter(const QString &name, bool powered)
+{
+    const QDBusMessage reply = call("AddAdapter", QList<QVariant>() << name << powered);
+    return reply.arguments().value(0).toString();
+}
+
+void FakeBluezFixture::removeAdapter(const QString &path)
+{
+    call("RemoveAdapter", QList<QVariant>() << path);
+}
+
+QStringList FakeBluezFixture::addDevices(const QString &adapterPath, int count, bool paired)
+{
+    const QDBusMessage reply = call("AddDevices", QList<QVariant>() << adapterPath << count << paired);
+    return reply.arguments().value(0).toStringList();
+}
+
+void FakeBluezFixture::removeDevice(const QString &path)
+{
+    call("RemoveDevice", QList<QVariant>() << path);
+}
+
+int FakeBluezFixture::removeDevices(const QString &adapterPath)
+{
+    const QDBusMessage reply = call("RemoveDevices", QList<QVariant>() << adapterPath);
+    return reply.arguments().value(0).toInt();
+}
+
+bool FakeBluezFixture::setProperty(const QString &path, const QString &property, const QVariant &value)
+{
+    const QDBusMessage reply = call("SetProperty", QList<QVariant>() << path << property
+                                                                     << QVariant::fromValue(QDBusVariant(value)));
+    return reply.arguments().value(0).toBool();
+}
+
+bool FakeBluezFixture::invalidateProperty(const QString &path, const QString &property)
+{
+    const QDBusMessage reply = call("InvalidateProperty", QList<QVariant>() << path << property);
+    return reply.arguments().value(0).toBool();
+}
+
+void FakeBluezFixture::startPropertyChanges(const QString &property, int count, int rate)
+{
+    call("StartPropertyChanges", QList<QVariant>() << property << count << rate);
+}
+
+QVariantMap FakeBluezFixture::discoveryFilter(const QString &adapterPath)
+{
+    const QDBusMessage reply = call("DiscoveryFilter", QList<QVariant>() << adapterPath);
+    return qdbus_cast<QVariantMap>(reply.arguments().value(0));
+}
+
+QStringList FakeBluezFixture::agents()
+{
+    return call("Agents").arguments().value(0).toStringList();
+}
+
+void FakeBluezFixture::holdConnects(bool hold)
+{
+    call("HoldConnects", QList<QVariant>() << hold);
+}
+
+void FakeBluezFixture::holdManagedObjects(bool hold)
+{
+    call("HoldManagedObjects", QList<QVariant>() << hold);
+}
+
+QDBusMessage FakeBluezFixture::call(const QString &method, const QList<QVariant> &arguments)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall("org.bluez", "/", "org.kde.BlueDevil.FakeBluez", method);
+    message.setArguments(arguments);
+
+    // Populating fakebluez with tens of thousands of devices takes longer than the default timeout
+    const QDBusMessage reply = QDBusConnection::systemBus().call(message, QDBus::Block, 300000);
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        qWarning() << "fakebluez call failed:" << method << reply.errorMessage();
+    }
+    return reply;
+}
+
+bool FakeBluezFixture::waitForBluez(bool registered)
+{
+    QDBusConnectionInterface *const interface = QDBusConnection::systemBus().interface();
+    for (int elapsed = 0; elapsed < 5000; elapsed += 10) {
+        if (interface->isServiceRegistered("org.bluez").value() == registered) {
+            return true;
+        }
+        QTest::qWait(10);
+    }
+    return false;
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef FAKEBLUEZFIXTURE_H
+#define FAKEBLUEZFIXTURE_H
+
+#include <QtCore/QProcess>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+#include <QtDBus/QDBusMessage>
+#include <QtTest/QTest>
+
+/**
+ * Waits, processing events, until @p expr is true or five seconds have passed, and then verifies
+ * it. Qt 4 does not have QTRY_VERIFY.
+ */
+#define BLUEDEVIL_TRY_VERIFY(expr) \
+    do { \
+        for (int _elapsed = 0; _elapsed < 5000 && !(expr); _elapsed += 10) { \
+            QTest::qWait(10); \
+        } \
+        QVERIFY(expr); \
+    } while (0)
+
+/**
+ * Runs a private dbus-daemon, makes it the system bus of this process through
+ * DBUS_SYSTEM_BUS_ADDRESS, and runs fakebluez on it.
+ *
+ * startBus() has to be called before anything in the process touches QDBusConnection::systemBus().
+ */
+class FakeBluezFixture
+{
+public:
+    FakeBluezFixture();
+    ~FakeBluezFixture();
+
+    bool startBus();
+    void stopBus();
+
+    bool startBluez(int adapters = 1, int devices = 0, int paired = 0);
+    void stopBluez();
+
+    QString addAdapter(const QString &name, bool powered = true);
+    void removeAdapter(const QString &path);
+    QStringList addDevices(const QString &adapterPath, int count, bool paired = false);
+    void removeDevice(const QString &path);
+    int removeDevices(const QString &adapterPath);
+    bool setProperty(const QString &path, const QString &property, const QVariant &value);
+    bool invalidateProperty(const QString &path, const QString &property);
+    void startPropertyChanges(const QString &property, int count, int rate);
+    QVariantMap discoveryFilter(const QString &adapterPath);
+    QStringList agents();
+    void holdConnects(bool hold);
+    void holdManagedObjects(bool hold);
+
+private:
+    QDBusMessage call(const QString &method, const QList<QVariant> &arguments = QList<QVariant>());
+    bool waitForBluez(bool registered);
+
+    QProcess m_bus;
+    QProcess m_bluez;
+};
+
+#endif // FAKEBLUEZFIXTURE_H
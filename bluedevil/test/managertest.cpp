@@ -0,0 +1,1230 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+
+#include "managertest.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+#include <bluedevil/bluedeviladapter.h>
+#include <bluedevil/bluedevilmanager.h>
+#include <bluedevil/bluedevildevice.h>
+#include <bluedevil/bluedevildeviceview.h>
+#include <bluedevil/bluedevildiscoveryfilter.h>
+#include <bluedevil/bluedeviloperationscheduler.h>
+#include <bluedevil/bluedevilpendingcall.h>
+#include <bluedevil/bluedevilrssihistory.h>
+#include <bluedevil/bluedeviltracereplayer.h>
+#include <bluedevil/bluedevilutils.h>
+
+using namespace BlueDevil;
+
+Q_DECLARE_METATYPE(BlueDevil::Device*)
+Q_DECLARE_METATYPE(QList<BlueDevil::Device*>)
+
+// fakebluez numbers its adapters in creation order
+static const char *firstAdapterPath = "/org/bluez/hci0";
+
+static CallStatistics findCall(const BusStatistics &statistics, const QString &interface, const QString &member,
+                               CallStatistics::Type type)
+{
+    Q_FOREACH (const CallStatistics &call, statistics.calls) {
+        if (call.interface == interface && call.member == member && call.type == type) {
+            return call;
+        }
+    }
+    CallStatistics none;
+    none.count = 0;
+    return none;
+}
+
+void ManagerTest::initTestCase()
+{
+    qRegisterMetaType<Adapter*>("Adapter*");
+    qRegisterMetaType<Device*>("Device*");
+    qRegisterMetaType<QList<Device*> >("QList<Device*>");
+    qRegisterMetaType<qint16>("qint16");
+
+    QVERIFY(m_fixture.startBus());
+}
+
+void ManagerTest::cleanup()
+{
+    Manager::release();
+    Manager::setInitializationMode(Manager::BlockingInitialization);
+    Manager::setSnapshotPath(QString());
+    Manager::setDBusThreadEnabled(false);
+    m_fixture.stopBluez();
+}
+
+void ManagerTest::cleanupTestCase()
+{
+    m_fixture.stopBus();
+}
+
+void ManagerTest::testAdapters()
+{
+    QVERIFY(m_fixture.startBluez(2, 0));
+
+    Manager *const manager = Manager::self();
+    QVERIFY(manager->isInitialized());
+    QVERIFY(manager->isBluetoothOperational());
+    QCOMPARE(manager->adapters().count(), 2);
+
+    Adapter *const adapter = manager->usableAdapter();
+    QVERIFY(adapter);
+    QVERIFY(adapter->isPowered());
+    QVERIFY(adapter->name().startsWith("fakebluez #"));
+    QCOMPARE(adapter->address().count(':'), 5);
+    QCOMPARE(adapter->adapterClass(), quint32(0x0c010c));
+    QCOMPARE(adapter->discoverableTimeout(), quint32(180));
+    QVERIFY(adapter->isPairable());
+    QVERIFY(!adapter->isDiscovering());
+    QVERIFY(adapter->UUIDs().contains("00001200-0000-1000-8000-00805F9B34FB"));
+}
+
+void ManagerTest::testDevices()
+{
+    QVERIFY(m_fixture.startBluez(1, 5, 2));
+
+    Manager *const manager = Manager::self();
+    Adapter *const adapter = manager->usableAdapter();
+    QVERIFY(adapter);
+    QCOMPARE(adapter->devices().count(), 5);
+    QCOMPARE(adapter->unpairedDevices().count(), 3);
+    QCOMPARE(manager->devices().count(), 5);
+
+    Q_FOREACH (Device *const device, adapter->devices()) {
+        QCOMPARE(device->adapter(), adapter);
+        QVERIFY(device->name().startsWith("Device "));
+        QCOMPARE(device->alias(), device->name());
+        QCOMPARE(device->friendlyName(), device->name());
+        QCOMPARE(device->deviceClass(), quint32(0x240404));
+        QCOMPARE(device->icon(), QString("audio-card"));
+        QVERIFY(!device->isConnected());
+        QVERIFY(!device->isBlocked());
+        QVERIFY(device->UUIDs().contains("0000110B-0000-1000-8000-00805F9B34FB"));
+        QCOMPARE(device->isTrusted(), device->isPaired());
+
+        QCOMPARE(adapter->deviceForAddress(device->address()), device);
+        QCOMPARE(adapter->deviceForUBI(device->UBI()), device);
+        QCOMPARE(manager->deviceForUBI(device->UBI()), device);
+    }
+
+    // Listed by address
+    const QList<Device*> devices = adapter->devices();
+    for (int i = 1; i < devices.count(); ++i) {
+        QVERIFY(devices.at(i - 1)->address() < devices.at(i)->address());
+    }
+    QCOMPARE(manager->devices(), devices);
+    const QList<Device*> unpaired = adapter->unpairedDevices();
+    for (int i = 1; i < unpaired.count(); ++i) {
+        QVERIFY(unpaired.at(i - 1)->address() < unpaired.at(i)->address());
+    }
+}
+
+void ManagerTest::testUsableAdapterChanged()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Manager *const manager = Manager::self();
+    Adapter *const adapter = manager->usableAdapter();
+    QVERIFY(adapter);
+
+    QSignalSpy usableSpy(manager, SIGNAL(usableAdapterChanged(Adapter*)));
+    QVERIFY(m_fixture.setProperty(firstAdapterPath, "Powered", false));
+    BLUEDEVIL_TRY_VERIFY(usableSpy.count() == 1);
+    QVERIFY(!adapter->isPowered());
+    QVERIFY(!manager->usableAdapter());
+    QVERIFY(!manager->isBluetoothOperational());
+
+    QVERIFY(m_fixture.setProperty(firstAdapterPath, "Powered", true));
+    BLUEDEVIL_TRY_VERIFY(usableSpy.count() == 2);
+    QCOMPARE(manager->usableAdapter(), adapter);
+
+    QSignalSpy removedSpy(manager, SIGNAL(allAdaptersRemoved()));
+    m_fixture.removeAdapter(firstAdapterPath);
+    BLUEDEVIL_TRY_VERIFY(removedSpy.count() == 1);
+    QVERIFY(manager->adapters().isEmpty());
+    QVERIFY(!manager->usableAdapter());
+}
+
+void ManagerTest::testAdapterPropertyChanged()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+
+    QSignalSpy nameSpy(adapter, SIGNAL(nameChanged(QString)));
+    QSignalSpy discoveringSpy(adapter, SIGNAL(discoveringChanged(bool)));
+
+    QVERIFY(m_fixture.setProperty(firstAdapterPath, "Alias", QString("renamed")));
+    BLUEDEVIL_TRY_VERIFY(nameSpy.count() == 1);
+    QCOMPARE(nameSpy.at(0).at(0).toString(), QString("renamed"));
+    QCOMPARE(adapter->name(), QString("renamed"));
+
+    adapter->startDiscovery();
+    BLUEDEVIL_TRY_VERIFY(discoveringSpy.count() == 1);
+    QVERIFY(adapter->isDiscovering());
+
+    adapter->stopDiscovery();
+    BLUEDEVIL_TRY_VERIFY(discoveringSpy.count() == 2);
+    QVERIFY(!adapter->isDiscovering());
+}
+
+void ManagerTest::testAdapterPropertyInvalidated()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    QVERIFY(adapter->isPowered());
+
+    QSignalSpy nameSpy(adapter, SIGNAL(nameChanged(QString)));
+    QSignalSpy poweredSpy(adapter, SIGNAL(poweredChanged(bool)));
+    QSignalSpy discoverableSpy(adapter, SIGNAL(discoverableChanged(bool)));
+    QSignalSpy propertySpy(adapter, SIGNAL(propertyChanged(QString,QVariant)));
+
+    QVERIFY(m_fixture.setProperty(firstAdapterPath, "Discoverable", true));
+    BLUEDEVIL_TRY_VERIFY(discoverableSpy.count() == 1);
+    propertySpy.clear();
+
+    // Signalled like a change to the default value
+    QVERIFY(m_fixture.invalidateProperty(firstAdapterPath, "Alias"));
+    QVERIFY(m_fixture.invalidateProperty(firstAdapterPath, "Powered"));
+    QVERIFY(m_fixture.invalidateProperty(firstAdapterPath, "Discoverable"));
+    BLUEDEVIL_TRY_VERIFY(propertySpy.count() == 3);
+    QCOMPARE(nameSpy.count(), 1);
+    QCOMPARE(nameSpy.at(0).at(0).toString(), QString());
+    QCOMPARE(poweredSpy.count(), 1);
+    QCOMPARE(poweredSpy.at(0).at(0).toBool(), false);
+    QCOMPARE(discoverableSpy.count(), 2);
+    QCOMPARE(discoverableSpy.at(1).at(0).toBool(), false);
+    QVERIFY(!propertySpy.at(0).at(1).value<QVariant>().isValid());
+
+    QVERIFY(adapter->name().isEmpty());
+    QVERIFY(!adapter->isPowered());
+    QVERIFY(!adapter->isDiscoverable());
+}
+
+void ManagerTest::testDevicePropertyChanged()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    Device *const device = adapter->devices().value(0);
+    QVERIFY(device);
+
+    QSignalSpy nameSpy(device, SIGNAL(nameChanged(QString)));
+    QSignalSpy connectedSpy(device, SIGNAL(connectedChanged(bool)));
+    QSignalSpy deviceChangedSpy(adapter, SIGNAL(deviceChanged(Device*)));
+
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Name", QString("Headset")));
+    BLUEDEVIL_TRY_VERIFY(nameSpy.count() == 1);
+    QCOMPARE(device->name(), QString("Headset"));
+
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Connected", true));
+    BLUEDEVIL_TRY_VERIFY(connectedSpy.count() == 1);
+    QVERIFY(device->isConnected());
+    QCOMPARE(deviceChangedSpy.count(), 2);
+}
+
+void ManagerTest::testCoalescedDeviceChanges()
+{
+    QVERIFY(m_fixture.startBluez(1, 3));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    QCOMPARE(adapter->changeCoalescingInterval(), -1);
+    adapter->setChangeCoalescingInterval(500);
+
+    QList<Device*> devices = adapter->devices();
+    QCOMPARE(devices.count(), 3);
+
+    QSignalSpy devicesChangedSpy(adapter, SIGNAL(devicesChanged(QList<Device*>,quint32)));
+    QSignalSpy deviceChangedSpy(adapter, SIGNAL(deviceChanged(Device*)));
+
+    QVERIFY(m_fixture.setProperty(devices.at(0)->UBI(), "Name", QString("Headset")));
+    QVERIFY(m_fixture.setProperty(devices.at(1)->UBI(), "Connected", true));
+    QVERIFY(m_fixture.setProperty(devices.at(0)->UBI(), "Connected", true));
+    BLUEDEVIL_TRY_VERIFY(deviceChangedSpy.count() == 3);
+    QCOMPARE(devicesChangedSpy.count(), 0);
+
+    BLUEDEVIL_TRY_VERIFY(devicesChangedSpy.count() == 1);
+    const QList<Device*> changed = devicesChangedSpy.at(0).at(0).value<QList<Device*> >();
+    QCOMPARE(changed.count(), 2);
+    QCOMPARE(changed.at(0), devices.at(0));
+    QCOMPARE(changed.at(1), devices.at(1));
+    QCOMPARE(devicesChangedSpy.at(0).at(1).toUInt(), quint32(Device::NameProperty | Device::ConnectedProperty));
+
+    // Disabling coalescing delivers what is pending right away
+    QVERIFY(m_fixture.setProperty(devices.at(2)->UBI(), "Trusted", true));
+    BLUEDEVIL_TRY_VERIFY(deviceChangedSpy.count() == 4);
+    adapter->setChangeCoalescingInterval(-1);
+    QCOMPARE(devicesChangedSpy.count(), 2);
+    QCOMPARE(devicesChangedSpy.at(1).at(1).toUInt(), quint32(Device::TrustedProperty));
+
+    QVERIFY(m_fixture.setProperty(devices.at(2)->UBI(), "Trusted", false));
+    BLUEDEVIL_TRY_VERIFY(deviceChangedSpy.count() == 5);
+    QTest::qWait(100);
+    QCOMPARE(devicesChangedSpy.count(), 2);
+}
+
+void ManagerTest::testRSSI()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Device *const device = Manager::self()->devices().value(0);
+    QVERIFY(device);
+    QCOMPARE(device->RSSI(), qint16(-60));
+    QCOMPARE(device->RSSISamples().latest().RSSI, qint16(-60));
+    QVERIFY(device->RSSISamples().isEmpty());
+
+    device->setRSSIHistoryDepth(4);
+    QSignalSpy RSSISpy(device, SIGNAL(RSSIChanged(qint16)));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "RSSI", QVariant::fromValue<short>(-50)));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "RSSI", QVariant::fromValue<short>(-70)));
+    BLUEDEVIL_TRY_VERIFY(RSSISpy.count() == 2);
+
+    QCOMPARE(device->RSSI(), qint16(-70));
+    const RSSIHistory &samples = device->RSSISamples();
+    QCOMPARE(samples.count(), 2);
+    QCOMPARE(samples.at(0).RSSI, qint16(-50));
+    QVERIFY(samples.at(0).timestamp <= samples.at(1).timestamp);
+    QCOMPARE(samples.minimum(), qint16(-70));
+    QCOMPARE(samples.mean(), qreal(-60));
+
+    // Out of range, the reading goes away without adding a sample
+    QVERIFY(m_fixture.invalidateProperty(device->UBI(), "RSSI"));
+    BLUEDEVIL_TRY_VERIFY(RSSISpy.count() == 3);
+    QCOMPARE(RSSISpy.at(2).at(0).value<qint16>(), qint16(0));
+    QCOMPARE(device->RSSI(), qint16(0));
+    QCOMPARE(samples.count(), 2);
+}
+
+void ManagerTest::testDeviceType()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    QCOMPARE(adapter->modalias(), QString("usb:v1D6Bp0246d0525"));
+
+    Device *const device = adapter->devices().value(0);
+    QVERIFY(device);
+    QCOMPARE(device->modalias(), QString("bluetooth:v000Ap1234d0100"));
+    QCOMPARE(device->appearance(), quint16(0));
+    QCOMPARE(device->type(), quint32(BLUETOOTH_TYPE_HEADSET));
+
+    // Like an LE mouse, which has no class
+    QSignalSpy propertySpy(device, SIGNAL(propertyChanged(QString,QVariant)));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Class", 0u));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Appearance", QVariant::fromValue<ushort>(0x03c2)));
+    BLUEDEVIL_TRY_VERIFY(propertySpy.count() == 2);
+    QCOMPARE(device->appearance(), quint16(0x03c2));
+    QCOMPARE(device->type(), quint32(BLUETOOTH_TYPE_MOUSE));
+
+    QCOMPARE(appearanceToType(0x0942), quint32(BLUETOOTH_TYPE_HEADSET));
+    QCOMPARE(appearanceToType(0x0040), quint32(BLUETOOTH_TYPE_PHONE));
+    QCOMPARE(appearanceToType(0x0c40), quint32(0));
+}
+
+void ManagerTest::testProfiles()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    QVERIFY(adapter->hasProfile("00001200-0000-1000-8000-00805F9B34FB"));
+    QCOMPARE(adapter->profiles(), quint32(BLUETOOTH_PROFILE_AVRCP));
+
+    Device *const device = adapter->devices().value(0);
+    QVERIFY(device);
+    QCOMPARE(device->UUIDs(), QStringList() << "0000110B-0000-1000-8000-00805F9B34FB"
+                                            << "0000111E-0000-1000-8000-00805F9B34FB");
+    QVERIFY(device->hasProfile("0000110b-0000-1000-8000-00805f9b34fb"));
+    QVERIFY(device->hasProfile("0000110B00001000800000805F9B34FB"));
+    QVERIFY(device->hasProfile("110b"));
+    QVERIFY(device->hasProfile("0x111E"));
+    QVERIFY(!device->hasProfile("110a"));
+    QVERIFY(!device->hasProfile("not a uuid"));
+    QCOMPARE(device->profiles(), quint32(BLUETOOTH_PROFILE_A2DP_SINK | BLUETOOTH_PROFILE_HANDSFREE));
+
+    QSignalSpy UUIDsSpy(device, SIGNAL(UUIDsChanged(QStringList)));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "UUIDs", QStringList() << "00001124-0000-1000-8000-00805f9b34fb"));
+    BLUEDEVIL_TRY_VERIFY(UUIDsSpy.count() == 1);
+    QVERIFY(device->hasProfile("1124"));
+    QVERIFY(!device->hasProfile("110b"));
+    QCOMPARE(device->profiles(), quint32(BLUETOOTH_PROFILE_HID));
+
+    QCOMPARE(UUIDToProfile("00001812-0000-1000-8000-00805f9b34fb"), quint32(BLUETOOTH_PROFILE_HID));
+    QCOMPARE(UUIDToProfile("1116"), quint32(BLUETOOTH_PROFILE_PAN));
+    QCOMPARE(UUIDToProfile("6e400001-b5a3-f393-e0a9-e50e24dcca9e"), quint32(0));
+}
+
+void ManagerTest::testDeviceAddedAndRemoved()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+
+    QSignalSpy foundSpy(adapter, SIGNAL(deviceFound(Device*)));
+    QSignalSpy unpairedSpy(adapter, SIGNAL(unpairedDeviceFound(Device*)));
+    QSignalSpy removedSpy(adapter, SIGNAL(deviceRemoved(Device*)));
+
+    const QStringList paths = m_fixture.addDevices(firstAdapterPath, 3);
+    QCOMPARE(paths.count(), 3);
+    BLUEDEVIL_TRY_VERIFY(foundSpy.count() == 3);
+    QCOMPARE(unpairedSpy.count(), 3);
+    QCOMPARE(adapter->devices().count(), 3);
+
+    Device *const device = adapter->deviceForUBI(paths.first());
+    QVERIFY(device);
+    adapter->removeDevice(device);
+    BLUEDEVIL_TRY_VERIFY(removedSpy.count() == 1);
+    QVERIFY(!adapter->deviceForUBI(paths.first()));
+    QVERIFY(!Manager::self()->deviceForUBI(paths.first()));
+    QCOMPARE(adapter->devices().count(), 2);
+    QCOMPARE(Manager::self()->deviceCount(), 2);
+
+    m_fixture.removeDevice(paths.last());
+    BLUEDEVIL_TRY_VERIFY(removedSpy.count() == 2);
+    QCOMPARE(adapter->devices().count(), 1);
+    QCOMPARE(adapter->unpairedDevices().count(), 1);
+}
+
+class CollectingVisitor
+    : public DeviceVisitor
+{
+public:
+    CollectingVisitor(int limit)
+        : m_limit(limit)
+    {
+    }
+
+    virtual bool visit(Device *device)
+    {
+        m_devices << device;
+        return m_devices.count() < m_limit;
+    }
+
+    int            m_limit;
+    QList<Device*> m_devices;
+};
+
+void ManagerTest::testVisitDevices()
+{
+    QVERIFY(m_fixture.startBluez(1, 4));
+    const QString secondAdapterPath = m_fixture.addAdapter("second");
+    QCOMPARE(m_fixture.addDevices(secondAdapterPath, 3).count(), 3);
+
+    Manager *const manager = Manager::self();
+    BLUEDEVIL_TRY_VERIFY(manager->deviceCount() == 7);
+
+    CollectingVisitor all(100);
+    manager->visitDevices(&all);
+    QCOMPARE(all.m_devices.count(), 7);
+    QCOMPARE(all.m_devices.toSet(), manager->devices().toSet());
+    Q_FOREACH (Device *const device, all.m_devices) {
+        QCOMPARE(manager->deviceForUBI(device->UBI()), device);
+    }
+
+    CollectingVisitor some(3);
+    manager->visitDevices(&some);
+    QCOMPARE(some.m_devices.count(), 3);
+}
+
+void ManagerTest::testDeviceView()
+{
+    QVERIFY(m_fixture.startBluez(1, 4, 2));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+
+    DevicePropertyPredicate *const predicate = new DevicePropertyPredicate;
+    predicate->requirePaired(true);
+    predicate->requireProfiles(BLUETOOTH_PROFILE_A2DP_SINK);
+    DeviceView view(adapter, predicate);
+    QCOMPARE(view.adapter(), adapter);
+    QCOMPARE(view.count(), 2);
+
+    Device *unpaired = 0;
+    Q_FOREACH (Device *device, adapter->devices()) {
+        QCOMPARE(view.contains(device), device->isPaired());
+        if (!device->isPaired()) {
+            unpaired = device;
+        }
+    }
+    QVERIFY(unpaired);
+
+    QSignalSpy insertedSpy(&view, SIGNAL(deviceInserted(Device*)));
+    QSignalSpy removedSpy(&view, SIGNAL(deviceRemoved(Device*)));
+    QSignalSpy changedSpy(&view, SIGNAL(deviceChanged(Device*,quint32)));
+
+    QVERIFY(m_fixture.setProperty(unpaired->UBI(), "Paired", true));
+    BLUEDEVIL_TRY_VERIFY(insertedSpy.count() == 1);
+    QCOMPARE(insertedSpy.at(0).at(0).value<Device*>(), unpaired);
+    QCOMPARE(view.count(), 3);
+    QCOMPARE(view.at(2), unpaired);
+
+    // Not a dependency of the predicate, the device stays
+    QVERIFY(m_fixture.setProperty(unpaired->UBI(), "Alias", QString("Kitchen")));
+    BLUEDEVIL_TRY_VERIFY(changedSpy.count() == 1);
+    QCOMPARE(changedSpy.at(0).at(1).toUInt(), quint32(Device::AliasProperty));
+
+    QVERIFY(m_fixture.setProperty(unpaired->UBI(), "UUIDs", QStringList() << "00001124-0000-1000-8000-00805f9b34fb"));
+    BLUEDEVIL_TRY_VERIFY(removedSpy.count() == 1);
+    QVERIFY(!view.contains(unpaired));
+
+    Device *const member = view.at(0);
+    m_fixture.removeDevice(member->UBI());
+    BLUEDEVIL_TRY_VERIFY(removedSpy.count() == 2);
+    QCOMPARE(view.count(), 1);
+
+    DevicePropertyPredicate *const connected = new DevicePropertyPredicate;
+    connected->requireConnected(true);
+    view.setPredicate(connected);
+    QVERIFY(view.isEmpty());
+    QCOMPARE(removedSpy.count(), 3);
+
+    // A view of all adapters follows the ones added later on
+    DeviceView allDevices;
+    QCOMPARE(allDevices.count(), Manager::self()->deviceCount());
+    QSignalSpy allInsertedSpy(&allDevices, SIGNAL(deviceInserted(Device*)));
+    QSignalSpy allRemovedSpy(&allDevices, SIGNAL(deviceRemoved(Device*)));
+    const QString secondAdapterPath = m_fixture.addAdapter("second");
+    m_fixture.addDevices(secondAdapterPath, 2);
+    BLUEDEVIL_TRY_VERIFY(allInsertedSpy.count() == 2);
+    QCOMPARE(allDevices.count(), Manager::self()->deviceCount());
+
+    m_fixture.removeAdapter(secondAdapterPath);
+    BLUEDEVIL_TRY_VERIFY(allRemovedSpy.count() == 2);
+    QCOMPARE(allDevices.count(), Manager::self()->deviceCount());
+}
+
+void ManagerTest::testSetters()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    Device *const device = adapter->devices().value(0);
+    QVERIFY(device);
+
+    QSignalSpy discoverableSpy(adapter, SIGNAL(discoverableChanged(bool)));
+    adapter->setDiscoverable(true);
+    BLUEDEVIL_TRY_VERIFY(discoverableSpy.count() == 1);
+    QVERIFY(adapter->isDiscoverable());
+
+    QSignalSpy trustedSpy(device, SIGNAL(trustedChanged(bool)));
+    QSignalSpy aliasSpy(device, SIGNAL(aliasChanged(QString)));
+    device->setTrusted(true);
+    device->setAlias("My Headset");
+    BLUEDEVIL_TRY_VERIFY(trustedSpy.count() == 1 && aliasSpy.count() == 1);
+    QVERIFY(device->isTrusted());
+    QCOMPARE(device->alias(), QString("My Headset"));
+    QVERIFY(device->friendlyName().startsWith("My Headset ("));
+}
+
+void ManagerTest::testMethods()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    Device *const device = adapter->devices().value(0);
+    QVERIFY(device);
+    QVERIFY(!device->isPaired());
+
+    QSignalSpy pairedSpy(device, SIGNAL(pairedChanged(bool)));
+    QSignalSpy connectedSpy(device, SIGNAL(connectedChanged(bool)));
+
+    device->pair();
+    BLUEDEVIL_TRY_VERIFY(pairedSpy.count() == 1);
+    QVERIFY(device->isPaired());
+
+    device->connectDevice();
+    BLUEDEVIL_TRY_VERIFY(connectedSpy.count() == 1);
+    QVERIFY(device->isConnected());
+
+    device->disconnect();
+    BLUEDEVIL_TRY_VERIFY(connectedSpy.count() == 2);
+    QVERIFY(!device->isConnected());
+}
+
+void ManagerTest::testPendingCalls()
+{
+    QVERIFY(m_fixture.startBluez(1, 20));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    QCOMPARE(adapter->devices().count(), 20);
+
+    // All the calls are in flight at the same time
+    QList<QSignalSpy*> spies;
+    Q_FOREACH (Device *device, adapter->devices()) {
+        PendingCall *const call = device->connectDevice();
+        QVERIFY(!call->isFinished());
+        spies << new QSignalSpy(call, SIGNAL(finished(bool,QString)));
+    }
+    Q_FOREACH (QSignalSpy *spy, spies) {
+        BLUEDEVIL_TRY_VERIFY(spy->count() == 1);
+        QCOMPARE(spy->at(0).at(0).toBool(), true);
+        QVERIFY(spy->at(0).at(1).toString().isEmpty());
+    }
+    qDeleteAll(spies);
+    Q_FOREACH (Device *device, adapter->devices()) {
+        QVERIFY(device->isConnected());
+    }
+
+    Device *const device = adapter->devices().value(0);
+    PendingCall *call = device->pair();
+    call->waitForFinished();
+    QVERIFY(call->isFinished());
+    QVERIFY(!call->isError());
+
+    // BlueZ refuses to pair twice
+    call = device->pair();
+    QSignalSpy finishedSpy(call, SIGNAL(finished(bool,QString)));
+    BLUEDEVIL_TRY_VERIFY(finishedSpy.count() == 1);
+    QCOMPARE(finishedSpy.at(0).at(0).toBool(), false);
+    QCOMPARE(finishedSpy.at(0).at(1).toString(), QString("org.bluez.Error.AlreadyExists"));
+
+    call = device->cancelPairing();
+    QSignalSpy cancelSpy(call, SIGNAL(finished(bool,QString)));
+    BLUEDEVIL_TRY_VERIFY(cancelSpy.count() == 1);
+    QCOMPARE(cancelSpy.at(0).at(1).toString(), QString("org.bluez.Error.DoesNotExist"));
+
+    call = device->disconnectProfile("0000110b-0000-1000-8000-00805f9b34fb");
+    call->waitForFinished();
+    QVERIFY(!call->isError());
+    BLUEDEVIL_TRY_VERIFY(!device->isConnected());
+
+    call = device->connectProfile("0000110b-0000-1000-8000-00805f9b34fb");
+    call->waitForFinished();
+    QVERIFY(!call->isError());
+    BLUEDEVIL_TRY_VERIFY(device->isConnected());
+
+    call = device->connectProfile("00001124-0000-1000-8000-00805f9b34fb");
+    call->waitForFinished();
+    QVERIFY(call->isError());
+    QCOMPARE(call->errorName(), QString("org.bluez.Error.InvalidArguments"));
+
+    call = Manager::self()->registerAgent("/org/kde/bluedevil/test/agent", static_cast<Manager::RegisterCapability>(-1));
+    QSignalSpy invalidSpy(call, SIGNAL(finished(bool,QString)));
+    BLUEDEVIL_TRY_VERIFY(invalidSpy.count() == 1);
+    QCOMPARE(invalidSpy.at(0).at(0).toBool(), false);
+    QVERIFY(m_fixture.agents().isEmpty());
+}
+
+void ManagerTest::testOperationScheduler()
+{
+    QVERIFY(m_fixture.startBluez(1, 6));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    const QList<Device*> devices = adapter->devices();
+    QCOMPARE(devices.count(), 6);
+
+    OperationScheduler *const scheduler = adapter->operationScheduler();
+    QCOMPARE(adapter->operationScheduler(), scheduler);
+    QCOMPARE(scheduler->maxConcurrentOperations(), 1);
+    scheduler->setMaxConcurrentOperations(2);
+
+    QSignalSpy finishedSpy(scheduler, SIGNAL(operationFinished(Device*,BlueDevil::OperationScheduler::Operation,bool,QString)));
+    QSignalSpy idleSpy(scheduler, SIGNAL(idle()));
+
+    for (int i = 0; i < 5; ++i) {
+        scheduler->connectDevice(devices.at(i));
+    }
+    QCOMPARE(scheduler->runningCount(), 2);
+    QCOMPARE(scheduler->queuedCount(), 3);
+
+    // Jumps ahead of the normal priority ones still queued
+    scheduler->connectDevice(devices.at(5), OperationScheduler::HighPriority);
+
+    PendingCall *const canceled = scheduler->disconnectDevice(devices.at(1), OperationScheduler::LowPriority);
+    QSignalSpy canceledSpy(canceled, SIGNAL(finished(bool,QString)));
+    QVERIFY(scheduler->cancel(canceled));
+    QCOMPARE(canceledSpy.count(), 1);
+    QCOMPARE(canceledSpy.at(0).at(1).toString(), QString("org.kde.BlueDevil.Error.Canceled"));
+    QCOMPARE(scheduler->queuedCount(), 4);
+    QVERIFY(!scheduler->cancel(canceled));
+
+    BLUEDEVIL_TRY_VERIFY(idleSpy.count() == 1);
+    QCOMPARE(finishedSpy.count(), 7);
+    QCOMPARE(finishedSpy.at(0).at(0).value<Device*>(), devices.at(1));
+    QCOMPARE(finishedSpy.at(0).at(2).toBool(), false);
+
+    QList<Device*> connectOrder;
+    for (int i = 1; i < finishedSpy.count(); ++i) {
+        QCOMPARE(finishedSpy.at(i).at(2).toBool(), true);
+        connectOrder << finishedSpy.at(i).at(0).value<Device*>();
+    }
+    QVERIFY(connectOrder.indexOf(devices.at(5)) <= 2);
+    Q_FOREACH (Device *device, devices) {
+        QVERIFY(device->isConnected());
+    }
+
+    // The second call is only sent once the first one has finished
+    scheduler->setMaxConcurrentOperations(1);
+    scheduler->disconnectDevice(devices.at(0));
+    PendingCall *const queued = scheduler->connectProfile(devices.at(0), "00001124-0000-1000-8000-00805f9b34fb");
+    QCOMPARE(scheduler->queuedCount(), 1);
+    queued->waitForFinished();
+    QVERIFY(queued->isFinished());
+    QCOMPARE(queued->errorName(), QString("org.bluez.Error.InvalidArguments"));
+    BLUEDEVIL_TRY_VERIFY(idleSpy.count() == 2);
+    BLUEDEVIL_TRY_VERIFY(!devices.at(0)->isConnected());
+
+    // A device removed while its connection is in flight does not hold up the queue
+    m_fixture.holdConnects(true);
+    const QString removedUBI = devices.at(0)->UBI();
+    PendingCall *const orphaned = scheduler->connectDevice(devices.at(0));
+    QSignalSpy orphanedSpy(orphaned, SIGNAL(finished(bool,QString)));
+    scheduler->connectDevice(devices.at(1));
+    QCOMPARE(scheduler->runningCount(), 1);
+    QCOMPARE(scheduler->queuedCount(), 1);
+    finishedSpy.clear();
+
+    m_fixture.removeDevice(removedUBI);
+    BLUEDEVIL_TRY_VERIFY(orphanedSpy.count() == 1);
+    QCOMPARE(orphanedSpy.at(0).at(1).toString(), QString("org.freedesktop.DBus.Error.UnknownObject"));
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!finishedSpy.at(0).at(0).value<Device*>());
+    QCOMPARE(scheduler->runningCount(), 1);
+    QCOMPARE(scheduler->queuedCount(), 0);
+
+    m_fixture.holdConnects(false);
+    BLUEDEVIL_TRY_VERIFY(idleSpy.count() == 3);
+    QCOMPARE(finishedSpy.count(), 2);
+    QCOMPARE(finishedSpy.at(1).at(0).value<Device*>(), devices.at(1));
+    QCOMPARE(finishedSpy.at(1).at(2).toBool(), true);
+
+    // Running and queued requests alike finish once when the adapter goes away
+    m_fixture.holdConnects(true);
+    QSignalSpy runningSpy(scheduler->connectDevice(devices.at(2)), SIGNAL(finished(bool,QString)));
+    QSignalSpy queuedSpy(scheduler->connectDevice(devices.at(3)), SIGNAL(finished(bool,QString)));
+    QCOMPARE(scheduler->runningCount(), 1);
+    QCOMPARE(scheduler->queuedCount(), 1);
+
+    Manager::release();
+    QCOMPARE(runningSpy.count(), 1);
+    QCOMPARE(runningSpy.at(0).at(1).toString(), QString("org.kde.BlueDevil.Error.Canceled"));
+    QCOMPARE(queuedSpy.count(), 1);
+    QCOMPARE(queuedSpy.at(0).at(1).toString(), QString("org.kde.BlueDevil.Error.Canceled"));
+    m_fixture.holdConnects(false);
+}
+
+void ManagerTest::testAsyncCall()
+{
+    QVERIFY(m_fixture.startBluez(1, 1));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+    Device *const device = adapter->devices().value(0);
+    QVERIFY(device);
+
+    QSignalSpy UBISpy(device, SIGNAL(UBIResult(Device*,QString)));
+    QSignalSpy UUIDsSpy(device, SIGNAL(UUIDsResult(Device*,QStringList)));
+    QSignalSpy connectedSpy(device, SIGNAL(isConnectedResult(Device*,bool)));
+    QSignalSpy connectedChangedSpy(device, SIGNAL(connectedChanged(bool)));
+
+    // Results are never delivered from within asyncCall
+    asyncCall(device, SLOT(UBI()));
+    asyncCall(device, SLOT(UUIDs()));
+    QCOMPARE(UBISpy.count(), 0);
+    QCOMPARE(UUIDsSpy.count(), 0);
+
+    BLUEDEVIL_TRY_VERIFY(UBISpy.count() == 1);
+    QCOMPARE(UBISpy.at(0).at(1).toString(), device->UBI());
+    BLUEDEVIL_TRY_VERIFY(UUIDsSpy.count() == 1);
+    QCOMPARE(UUIDsSpy.at(0).at(1).toStringList(), device->UUIDs());
+
+    asyncCall(device, SLOT(connectDevice()));
+    BLUEDEVIL_TRY_VERIFY(connectedChangedSpy.count() == 1);
+
+    asyncCall(device, SLOT(isConnected()));
+    BLUEDEVIL_TRY_VERIFY(connectedSpy.count() == 1);
+    QCOMPARE(connectedSpy.at(0).at(1).toBool(), true);
+}
+
+void ManagerTest::testDiscoveryFilter()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Adapter *const adapter = Manager::self()->usableAdapter();
+    QVERIFY(adapter);
+
+    DiscoveryFilter filter;
+    QVERIFY(filter.isEmpty());
+    QVERIFY(filter.toVariantMap().isEmpty());
+
+    filter.setTransport(DiscoveryFilter::LeTransport);
+    filter.setPathloss(10);
+    filter.setRSSI(-70);
+    QVERIFY(!filter.hasPathloss());
+    filter.setUUIDs(QStringList() << "0000110b-0000-1000-8000-00805f9b34fb");
+    filter.setDuplicateData(false);
+    QVERIFY(!filter.isEmpty());
+
+    DiscoveryFilter copy = filter;
+    QVERIFY(copy == filter);
+    copy.setTransport(DiscoveryFilter::BrEdrTransport);
+    QVERIFY(copy != filter);
+    QCOMPARE(filter.transport(), DiscoveryFilter::LeTransport);
+
+    PendingCall *call = adapter->setDiscoveryFilter(filter);
+    QSignalSpy setSpy(call, SIGNAL(finished(bool,QString)));
+    BLUEDEVIL_TRY_VERIFY(setSpy.count() == 1);
+    QCOMPARE(setSpy.at(0).at(0).toBool(), true);
+
+    const QVariantMap applied = m_fixture.discoveryFilter(firstAdapterPath);
+    QCOMPARE(applied.value("Transport").toString(), QString("le"));
+    QCOMPARE(applied.value("RSSI").toInt(), -70);
+    QVERIFY(!applied.contains("Pathloss"));
+    QCOMPARE(applied.value("UUIDs").toStringList(), filter.UUIDs());
+    QCOMPARE(applied.value("DuplicateData").toBool(), false);
+
+    call = adapter->clearDiscoveryFilter();
+    QSignalSpy clearSpy(call, SIGNAL(finished(bool,QString)));
+    BLUEDEVIL_TRY_VERIFY(clearSpy.count() == 1);
+    QCOMPARE(clearSpy.at(0).at(0).toBool(), true);
+    QVERIFY(m_fixture.discoveryFilter(firstAdapterPath).isEmpty());
+}
+
+void ManagerTest::testAgentManager()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+
+    Manager *const manager = Manager::self();
+    manager->registerAgent("/org/kde/bluedevil/test/agent", Manager::DisplayYesNo);
+    BLUEDEVIL_TRY_VERIFY(m_fixture.agents().contains("/org/kde/bluedevil/test/agent"));
+
+    manager->unregisterAgent("/org/kde/bluedevil/test/agent");
+    BLUEDEVIL_TRY_VERIFY(m_fixture.agents().isEmpty());
+}
+
+void ManagerTest::testNonBlockingInitialization()
+{
+    QVERIFY(m_fixture.startBluez(2, 3));
+
+    Manager::setInitializationMode(Manager::NonBlockingInitialization);
+    Manager *const manager = Manager::self();
+    QVERIFY(!manager->isInitialized());
+
+    QSignalSpy initializedSpy(manager, SIGNAL(initialized()));
+    QSignalSpy adapterAddedSpy(manager, SIGNAL(adapterAdded(Adapter*)));
+    BLUEDEVIL_TRY_VERIFY(initializedSpy.count() == 1);
+
+    QVERIFY(manager->isInitialized());
+    QCOMPARE(adapterAddedSpy.count(), 2);
+    QCOMPARE(manager->adapters().count(), 2);
+    QCOMPARE(manager->devices().count(), 6);
+    QVERIFY(manager->isBluetoothOperational());
+}
+
+void ManagerTest::testServiceRestart()
+{
+    QVERIFY(m_fixture.startBluez(1, 2));
+
+    Manager *const manager = Manager::self();
+    QVERIFY(manager->isBluetoothOperational());
+
+    QSignalSpy usableSpy(manager, SIGNAL(usableAdapterChanged(Adapter*)));
+    m_fixture.stopBluez();
+    BLUEDEVIL_TRY_VERIFY(!manager->isBluetoothOperational());
+    QVERIFY(manager->adapters().isEmpty());
+
+    QVERIFY(m_fixture.startBluez(1, 2));
+    BLUEDEVIL_TRY_VERIFY(manager->isBluetoothOperational());
+    QCOMPARE(manager->adapters().count(), 1);
+    QCOMPARE(manager->devices().count(), 2);
+    QVERIFY(usableSpy.count() >= 2);
+}
+
+void ManagerTest::testSnapshot()
+{
+    const QString snapshotPath = QDir::tempPath() + "/bluedevil-managertest.snapshot";
+    QFile::remove(snapshotPath);
+    Manager::setSnapshotPath(snapshotPath);
+
+    QVERIFY(m_fixture.startBluez(1, 3, 2));
+
+    // There is no snapshot to present yet, one is written once initialized
+    Manager *manager = Manager::self();
+    QVERIFY(!manager->isProvisional());
+    QVERIFY(QFile::exists(snapshotPath));
+
+    QStringList paired;
+    Q_FOREACH (Device *device, manager->devices()) {
+        if (device->isPaired()) {
+            paired << device->UBI();
+        }
+    }
+    QCOMPARE(paired.count(), 2);
+    Manager::release();
+
+    QVERIFY(m_fixture.setProperty(paired.at(0), "Alias", QString("Renamed")));
+    m_fixture.removeDevice(paired.at(1));
+
+    // Only the paired devices were saved
+    manager = Manager::self();
+    QVERIFY(manager->isProvisional());
+    QVERIFY(!manager->isInitialized());
+    QVERIFY(manager->isBluetoothOperational());
+    QCOMPARE(manager->adapters().count(), 1);
+    QCOMPARE(manager->devices().count(), 2);
+
+    Adapter *const adapter = manager->adapters().first();
+    Device *const renamed = manager->deviceForUBI(paired.at(0));
+    QVERIFY(renamed);
+    QVERIFY(renamed->alias() != "Renamed");
+
+    QSignalSpy initializedSpy(manager, SIGNAL(initialized()));
+    QSignalSpy adapterAddedSpy(manager, SIGNAL(adapterAdded(Adapter*)));
+    QSignalSpy adapterPropertySpy(adapter, SIGNAL(propertyChanged(QString,QVariant)));
+    QSignalSpy foundSpy(adapter, SIGNAL(deviceFound(Device*)));
+    QSignalSpy removedSpy(adapter, SIGNAL(deviceRemoved(Device*)));
+    QSignalSpy aliasSpy(renamed, SIGNAL(aliasChanged(QString)));
+    QSignalSpy devicePropertySpy(renamed, SIGNAL(propertyChanged(QString,QVariant)));
+    const quint64 signalCount = Manager::busStatistics().signalCount;
+
+    BLUEDEVIL_TRY_VERIFY(initializedSpy.count() == 1);
+    QVERIFY(!manager->isProvisional());
+
+    // The removed device was reconciled, BlueZ did not signal it
+    QCOMPARE(Manager::busStatistics().signalCount, signalCount);
+    QCOMPARE(manager->adapters().first(), adapter);
+    QCOMPARE(manager->devices().count(), 2);
+
+    // Only the differences are signalled. RSSI is not saved, as it is only meaningful while
+    // discovering, which fakebluez does not model.
+    QCOMPARE(adapterAddedSpy.count(), 0);
+    QCOMPARE(adapterPropertySpy.count(), 0);
+    QCOMPARE(foundSpy.count(), 1);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(aliasSpy.count(), 1);
+    QCOMPARE(aliasSpy.at(0).at(0).toString(), QString("Renamed"));
+    QSet<QString> changedProperties;
+    for (int i = 0; i < devicePropertySpy.count(); ++i) {
+        changedProperties << devicePropertySpy.at(i).at(0).toString();
+    }
+    QCOMPARE(changedProperties, QSet<QString>() << "Alias" << "RSSI");
+
+    QVERIFY(manager->saveSnapshot());
+    QFile::remove(snapshotPath);
+}
+
+void ManagerTest::testTraceReplay()
+{
+    const QString tracePath = QDir::tempPath() + "/bluedevil-managertest.trace";
+    QVERIFY(m_fixture.startBluez(1, 3, 1));
+
+    Manager *manager = Manager::self();
+    QVERIFY(manager->startRecording(tracePath));
+    QVERIFY(manager->isRecording());
+
+    const QStringList added = m_fixture.addDevices(firstAdapterPath, 2);
+    QCOMPARE(added.count(), 2);
+    QVERIFY(m_fixture.setProperty(added.at(0), "Alias", QString("Replayed")));
+    m_fixture.removeDevice(added.at(1));
+    BLUEDEVIL_TRY_VERIFY(manager->deviceCount() == 4 && manager->deviceForUBI(added.at(0))
+                         && manager->deviceForUBI(added.at(0))->alias() == "Replayed");
+
+    // What has been recorded is on disk before the recording stops
+    BLUEDEVIL_TRY_VERIFY(QFileInfo(tracePath).size() > 8);
+
+    const QString recordedAdapterAddress = manager->adapters().first()->address();
+    QMap<QString, QString> recorded;
+    Q_FOREACH (Device *device, manager->devices()) {
+        recorded.insert(device->UBI(), device->alias());
+    }
+    manager->stopRecording();
+    QVERIFY(!manager->isRecording());
+    Manager::release();
+    m_fixture.stopBluez();
+
+    // No BlueZ from here on
+    manager = Manager::self();
+    QVERIFY(manager->adapters().isEmpty());
+
+    TraceReplayer replayer;
+    QVERIFY(replayer.load(tracePath));
+    replayer.setSpeed(TraceReplayer::MaximumSpeed);
+
+    QSignalSpy finishedSpy(&replayer, SIGNAL(finished()));
+    QSignalSpy adapterAddedSpy(manager, SIGNAL(adapterAdded(Adapter*)));
+
+    replayer.start();
+    QVERIFY(manager->isReplaying());
+    QVERIFY(replayer.isRunning());
+    BLUEDEVIL_TRY_VERIFY(finishedSpy.count() == 1);
+    QVERIFY(!replayer.isRunning());
+
+    // The initial adapter and devices, the two added ones, the alias change and the removal
+    QVERIFY(replayer.position() >= 8);
+    QCOMPARE(adapterAddedSpy.count(), 1);
+    QCOMPARE(manager->adapters().count(), 1);
+    QCOMPARE(manager->adapters().first()->address(), recordedAdapterAddress);
+    QVERIFY(manager->isBluetoothOperational());
+
+    QMap<QString, QString> replayed;
+    Q_FOREACH (Device *device, manager->devices()) {
+        replayed.insert(device->UBI(), device->alias());
+    }
+    QCOMPARE(replayed, recorded);
+
+    QFile::remove(tracePath);
+}
+
+void ManagerTest::testBusStatistics()
+{
+    QVERIFY(m_fixture.startBluez(1, 1, 0));
+
+    Manager::resetBusStatistics();
+    Manager *const manager = Manager::self();
+    Adapter *const adapter = manager->usableAdapter();
+    Device *const device = manager->devices().first();
+
+    BusStatistics statistics = Manager::busStatistics();
+    QCOMPARE(findCall(statistics, "org.freedesktop.DBus.ObjectManager", "GetManagedObjects", CallStatistics::MethodCall).synchronousCount,
+             quint64(1));
+
+    Manager::resetBusStatistics();
+    QVERIFY(Manager::busStatistics().calls.isEmpty());
+
+    // Getters are answered from the cache
+    adapter->isDiscoverable();
+    device->isConnected();
+    QVERIFY(findCall(Manager::busStatistics(), "org.bluez.Adapter1", "Discoverable", CallStatistics::GetCall).count == 0);
+    QVERIFY(findCall(Manager::busStatistics(), "org.bluez.Device1", "Connected", CallStatistics::GetCall).count == 0);
+
+    adapter->setDiscoverable(true);
+    statistics = Manager::busStatistics();
+    CallStatistics call = findCall(statistics, "org.bluez.Adapter1", "Discoverable", CallStatistics::SetCall);
+    QCOMPARE(call.count, quint64(1));
+    QCOMPARE(call.synchronousCount, quint64(1));
+    QCOMPARE(call.errorCount, quint64(0));
+    QVERIFY(call.maxLatency <= call.totalLatency);
+    quint64 histogramCount = 0;
+    for (int i = 0; i < CallStatistics::LatencyBuckets; ++i) {
+        histogramCount += call.latencyHistogram[i];
+    }
+    QCOMPARE(histogramCount, quint64(1));
+
+    PendingCall *const pendingCall = device->connectDevice();
+    QSignalSpy finishedSpy(pendingCall, SIGNAL(finished(bool,QString)));
+    QCOMPARE(Manager::busStatistics().callsInFlight, 1);
+    BLUEDEVIL_TRY_VERIFY(finishedSpy.count() == 1);
+
+    statistics = Manager::busStatistics();
+    QCOMPARE(statistics.callsInFlight, 0);
+    call = findCall(statistics, "org.bluez.Device1", "Connect", CallStatistics::MethodCall);
+    QCOMPARE(call.count, quint64(1));
+    QCOMPARE(call.synchronousCount, quint64(0));
+
+    // Discoverable and Connected changed
+    BLUEDEVIL_TRY_VERIFY(Manager::busStatistics().signalCount >= 2);
+
+    QCOMPARE(CallStatistics::latencyBucketBound(0), qint64(128));
+    QCOMPARE(CallStatistics::latencyBucketBound(1), qint64(256));
+    QCOMPARE(CallStatistics::latencyBucketBound(CallStatistics::LatencyBuckets - 1), qint64(-1));
+}
+
+/**
+ * Reads the published info from another thread.
+ */
+class InfoReader
+    : public QThread
+{
+public:
+    ManagerInfo info;
+
+protected:
+    virtual void run()
+    {
+        info = Manager::info();
+    }
+};
+
+void ManagerTest::testInfo()
+{
+    QVERIFY(m_fixture.startBluez(1, 2, 1));
+
+    // Published before self() returns
+    Manager *const manager = Manager::self();
+    const ManagerInfo info = Manager::info();
+    QVERIFY(info.isBluetoothOperational());
+    QCOMPARE(info.adapters().count(), 1);
+    QCOMPARE(info.usableAdapter().UBI(), QString(firstAdapterPath));
+    QCOMPARE(info.usableAdapter().devices().count(), 2);
+    QCOMPARE(info.devices().count(), 2);
+
+    Device *const device = manager->devices().first();
+    const QString UBI = device->UBI();
+    const DeviceInfo deviceInfo = info.deviceForUBI(UBI);
+    QVERIFY(!deviceInfo.isNull());
+    QCOMPARE(deviceInfo.adapterUBI(), QString(firstAdapterPath));
+    QCOMPARE(deviceInfo.address(), device->address());
+    QCOMPARE(deviceInfo.alias(), device->alias());
+    QCOMPARE(deviceInfo.isPaired(), device->isPaired());
+    QVERIFY(info.deviceForUBI("/org/bluez/hci0/dev_nope").isNull());
+
+    InfoReader reader;
+    reader.start();
+    QVERIFY(reader.wait(5000));
+    QCOMPARE(reader.info.generation(), info.generation());
+    QCOMPARE(reader.info.devices().count(), 2);
+
+    // A change publishes a new info, the one already taken stays as it was
+    QVERIFY(m_fixture.setProperty(UBI, "Alias", QString("Renamed")));
+    BLUEDEVIL_TRY_VERIFY(Manager::info().deviceForUBI(UBI).alias() == "Renamed");
+    QVERIFY(Manager::info().generation() > info.generation());
+    QVERIFY(deviceInfo.alias() != "Renamed");
+    QVERIFY(info.deviceForUBI(UBI).alias() != "Renamed");
+
+    // The info is built when read. Another thread gets the previous one meanwhile, and has the
+    // thread of the Manager build it.
+    const quint64 generation = Manager::info().generation();
+    QVERIFY(m_fixture.setProperty(UBI, "Alias", QString("Renamed again")));
+    BLUEDEVIL_TRY_VERIFY(device->alias() == "Renamed again");
+    reader.start();
+    QVERIFY(reader.wait(5000));
+    QCOMPARE(reader.info.generation(), generation);
+    QCoreApplication::processEvents();
+    reader.start();
+    QVERIFY(reader.wait(5000));
+    QCOMPARE(reader.info.generation(), generation + 1);
+    QCOMPARE(reader.info.deviceForUBI(UBI).alias(), QString("Renamed again"));
+
+    m_fixture.removeDevice(UBI);
+    BLUEDEVIL_TRY_VERIFY(Manager::info().devices().count() == 1);
+    QVERIFY(Manager::info().deviceForUBI(UBI).isNull());
+
+    Manager::release();
+    QVERIFY(Manager::info().adapters().isEmpty());
+    QVERIFY(!Manager::info().isBluetoothOperational());
+}
+
+void ManagerTest::testDBusThread()
+{
+    QVERIFY(m_fixture.startBluez(1, 2));
+
+    Manager::setDBusThreadEnabled(true);
+    Manager::resetBusStatistics();
+    Manager *const manager = Manager::self();
+    Adapter *const adapter = manager->usableAdapter();
+    QVERIFY(adapter);
+    QCOMPARE(adapter->devices().count(), 2);
+
+    QSignalSpy foundSpy(adapter, SIGNAL(deviceFound(Device*)));
+    QSignalSpy removedSpy(adapter, SIGNAL(deviceRemoved(Device*)));
+
+    // A burst of changes to the same device ends with its last value
+    Device *const device = adapter->devices().first();
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Name", QString("First")));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Name", QString("Second")));
+    QVERIFY(m_fixture.setProperty(device->UBI(), "Connected", true));
+    BLUEDEVIL_TRY_VERIFY(device->name() == "Second" && device->isConnected());
+
+    QVERIFY(m_fixture.setProperty(firstAdapterPath, "Alias", QString("Threaded")));
+    BLUEDEVIL_TRY_VERIFY(adapter->alias() == "Threaded");
+
+    const QStringList paths = m_fixture.addDevices(firstAdapterPath, 3);
+    BLUEDEVIL_TRY_VERIFY(foundSpy.count() == 3);
+    QVERIFY(manager->deviceForUBI(paths.first()));
+
+    m_fixture.removeDevice(paths.first());
+    BLUEDEVIL_TRY_VERIFY(removedSpy.count() == 1);
+    QVERIFY(!manager->deviceForUBI(paths.first()));
+    QCOMPARE(adapter->devices().count(), 4);
+
+    // Merged signals are still counted one by one
+    QVERIFY(Manager::busStatistics().signalCount >= 8);
+
+    // BlueZ going away stops the thread, and coming back starts it again
+    QSignalSpy removedAdapterSpy(manager, SIGNAL(adapterRemoved(Adapter*)));
+    QSignalSpy addedAdapterSpy(manager, SIGNAL(adapterAdded(Adapter*)));
+    m_fixture.stopBluez();
+    BLUEDEVIL_TRY_VERIFY(removedAdapterSpy.count() == 1);
+    QVERIFY(m_fixture.startBluez(1, 0));
+    BLUEDEVIL_TRY_VERIFY(addedAdapterSpy.count() == 1);
+
+    Adapter *const restartedAdapter = manager->usableAdapter();
+    QVERIFY(restartedAdapter);
+
+    // A burst of readings is not merged away from the RSSI history
+    m_fixture.addDevices(firstAdapterPath, 1);
+    BLUEDEVIL_TRY_VERIFY(restartedAdapter->devices().count() == 1);
+    Device *const scanned = restartedAdapter->devices().first();
+    scanned->setRSSIHistoryDepth(16);
+    QSignalSpy RSSISpy(scanned, SIGNAL(RSSIChanged(qint16)));
+    m_fixture.startPropertyChanges("RSSI", 8, 10000);
+    BLUEDEVIL_TRY_VERIFY(RSSISpy.count() == 8);
+    QCOMPARE(scanned->RSSISamples().count(), 8);
+
+    QSignalSpy restartedFoundSpy(restartedAdapter, SIGNAL(deviceFound(Device*)));
+    m_fixture.addDevices(firstAdapterPath, 1);
+    BLUEDEVIL_TRY_VERIFY(restartedFoundSpy.count() == 1);
+}
+
+void ManagerTest::testDBusThreadInitialization()
+{
+    QVERIFY(m_fixture.startBluez(1, 0));
+    const QStringList paths = m_fixture.addDevices(firstAdapterPath, 2);
+
+    // The reply to GetManagedObjects is built right away, but only sent when released
+    m_fixture.holdManagedObjects(true);
+    Manager::setDBusThreadEnabled(true);
+    Manager::setInitializationMode(Manager::NonBlockingInitialization);
+    Manager::resetBusStatistics();
+    Manager *const manager = Manager::self();
+    QSignalSpy initializedSpy(manager, SIGNAL(initialized()));
+
+    // GetManagedObjects is sent as soon as NameHasOwner is answered
+    BLUEDEVIL_TRY_VERIFY(findCall(Manager::busStatistics(), "org.freedesktop.DBus", "NameHasOwner", CallStatistics::MethodCall).count == 1);
+
+    // These reach the signal thread before the reply, which does not know about them
+    m_fixture.removeDevice(paths.at(0));
+    QVERIFY(m_fixture.setProperty(paths.at(1), "Name", QString("Late")));
+    BLUEDEVIL_TRY_VERIFY(Manager::busStatistics().signalCount >= 2);
+    QCOMPARE(initializedSpy.count(), 0);
+
+    m_fixture.holdManagedObjects(false);
+    BLUEDEVIL_TRY_VERIFY(initializedSpy.count() == 1);
+    QCOMPARE(manager->devices().count(), 1);
+    QVERIFY(!manager->deviceForUBI(paths.at(0)));
+    QVERIFY(manager->deviceForUBI(paths.at(1)));
+    QCOMPARE(manager->deviceForUBI(paths.at(1))->name(), QString("Late"));
+}
+
+QTEST_MAIN(ManagerTest)
+
+#include "managertest.moc"
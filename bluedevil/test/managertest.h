@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+
+#ifndef MANAGERTEST_H
+#define MANAGERTEST_H
+
+#include "fakebluezfixture.h"
+
+#include <QtCore/QObject>
+
+/**
+ * Drives Manager, Adapter and Device against fakebluez running on a private bus.
+ */
+class ManagerTest
+    : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void cleanupTestCase();
+
+    void testAdapters();
+    void testDevices();
+    void testUsableAdapterChanged();
+    void testAdapterPropertyChanged();
+    void testAdapterPropertyInvalidated();
+    void testDevicePropertyChanged();
+    void testCoalescedDeviceChanges();
+    void testRSSI();
+    void testDeviceType();
+    void testProfiles();
+    void testDeviceAddedAndRemoved();
+    void testVisitDevices();
+    void testDeviceView();
+    void testSetters();
+    void testMethods();
+    void testPendingCalls();
+    void testOperationScheduler();
+    void testAsyncCall();
+    void testDiscoveryFilter();
+    void testAgentManager();
+    void testNonBlockingInitialization();
+    void testServiceRestart();
+    void testSnapshot();
+    void testTraceReplay();
+    void testBusStatistics();
+    void testInfo();
+    void testDBusThread();
+    void testDBusThreadInitialization();
+
+private:
+    FakeBluezFixture m_fixture;
+};
+
+#endif // MANAGERTEST_H
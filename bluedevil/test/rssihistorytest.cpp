@@ -0,0 +1,111 @@
+/*****************************************************************************
+ * This file is part of the BlueDevil project                                *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "rssihistorytest.h"
+
+#include <QtTest/QTest>
+
+#include <bluedevil/bluedevilrssihistory.h>
+
+using namespace BlueDevil;
+
+void RSSIHistoryTest::testEmpty()
+{
+    RSSIHistory history;
+    QCOMPARE(history.capacity(), 0);
+    QVERIFY(history.isEmpty());
+    QCOMPARE(history.minimum(), qint16(0));
+    QCOMPARE(history.maximum(), qint16(0));
+    QCOMPARE(history.mean(), qreal(0));
+    QCOMPARE(history.latest().timestamp, qint64(0));
+
+    // Without capacity only the latest reading and the average are kept
+    history.append(10, -50);
+    QVERIFY(history.isEmpty());
+    QCOMPARE(history.latest().timestamp, qint64(10));
+    QCOMPARE(history.latest().RSSI, qint16(-50));
+    QCOMPARE(history.exponentialAverage(), qreal(-50));
+}
+
+void RSSIHistoryTest::testWrapAround()
+{
+    RSSIHistory history(3);
+    history.append(1, -40);
+    history.append(2, -50);
+    QCOMPARE(history.count(), 2);
+    QCOMPARE(history.mean(), qreal(-45));
+
+    history.append(3, -60);
+    history.append(4, -70);
+    history.append(5, -30);
+    QCOMPARE(history.count(), 3);
+    QCOMPARE(history.at(0).timestamp, qint64(3));
+    QCOMPARE(history.at(1).timestamp, qint64(4));
+    QCOMPARE(history.at(2).timestamp, qint64(5));
+    QCOMPARE(history.minimum(), qint16(-70));
+    QCOMPARE(history.maximum(), qint16(-30));
+    QCOMPARE(history.mean(), qreal(-160) / 3);
+
+    history.clear();
+    QVERIFY(history.isEmpty());
+    QCOMPARE(history.capacity(), 3);
+    QCOMPARE(history.mean(), qreal(0));
+}
+
+void RSSIHistoryTest::testSetCapacity()
+{
+    RSSIHistory history(4);
+    for (int i = 1; i <= 6; ++i) {
+        history.append(i, -40 - i);
+    }
+
+    // The newest samples are kept
+    history.setCapacity(2);
+    QCOMPARE(history.count(), 2);
+    QCOMPARE(history.at(0).timestamp, qint64(5));
+    QCOMPARE(history.at(1).timestamp, qint64(6));
+    QCOMPARE(history.mean(), qreal(-45.5));
+
+    history.setCapacity(5);
+    QCOMPARE(history.count(), 2);
+    history.append(7, -47);
+    QCOMPARE(history.count(), 3);
+    QCOMPARE(history.at(2).RSSI, qint16(-47));
+    QCOMPARE(history.minimum(), qint16(-47));
+}
+
+void RSSIHistoryTest::testExponentialAverage()
+{
+    RSSIHistory history(2);
+    history.setSmoothingFactor(0.5);
+    QCOMPARE(history.smoothingFactor(), qreal(0.5));
+    history.setSmoothingFactor(0);
+    QCOMPARE(history.smoothingFactor(), qreal(0.5));
+
+    history.append(1, -40);
+    QCOMPARE(history.exponentialAverage(), qreal(-40));
+    history.append(2, -60);
+    QCOMPARE(history.exponentialAverage(), qreal(-50));
+    history.append(3, -70);
+    QCOMPARE(history.exponentialAverage(), qreal(-60));
+}
+
+QTEST_MAIN(RSSIHistoryTest)
+
+#include "rssihistorytest.moc"